@@ -0,0 +1,146 @@
+/**
+ * Threaded scheduler dispatch benchmark.
+ *
+ * Runs a bursty workload on scheduler_pt for an increasing number of workers:
+ * all tasks share the same period, so every release puts the whole task set
+ * in the worker queues at once. Each callback spins for a fixed amount of
+ * work. Dispatch latency is the delay between the release time of a task and
+ * the start of its callback; throughput is the number of callbacks completed
+ * per second.
+ *
+ * Usage: rjos_bench_pt [duration_ms] [tasks] [work_us]
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "scheduler_pt.h"
+#include "system.h"
+#include "util/hist.h"
+
+#define BENCH_PERIOD_MS 20
+
+typedef struct bench_task {
+    sched_t *sched;
+    size_t   idx;       /**< Slot of the task, resolved on the first run */
+    int      resolved;
+    uint32_t work_us;
+    hist_t   latency;
+} bench_task_t;
+
+static void bench_callback(void *data) {
+    bench_task_t *bt = data;
+    uint64_t start_us = micros64();
+
+    /* sched_add_task() does not return the slot, so look it up on the first run. */
+    if (!bt->resolved) {
+        for (size_t i = 0; i < bt->sched->tasks_count; i++) {
+            if (bt->sched->tasks[i].data == bt) {
+                bt->idx = i;
+                break;
+            }
+        }
+        bt->resolved = 1;
+    }
+    uint64_t release_us = bt->sched->tasks[bt->idx].release_us;
+    hist_record(&bt->latency, start_us > release_us ? start_us - release_us : 0);
+
+    while (micros64() - start_us < bt->work_us) {
+    }
+}
+
+static void *bench_thread(void *arg) {
+    sched_pt_start(arg);
+    return NULL;
+}
+
+static int run(size_t workers, size_t tasks, uint32_t work_us, uint32_t duration_ms) {
+    sched_t sched;
+    if (sched_pt_init(&sched, tasks, workers) != 0) {
+        return -1;
+    }
+    sched_set_histograms(&sched, 0);
+
+    bench_task_t *bts = calloc(tasks, sizeof(bench_task_t));
+    if (!bts) {
+        sched_pt_destroy(&sched);
+        return -1;
+    }
+    for (size_t i = 0; i < tasks; i++) {
+        bts[i].sched   = &sched;
+        bts[i].work_us = work_us;
+        if (sched_add_task(&sched, bench_callback, &bts[i], BENCH_PERIOD_MS, 1, "bench") != 0) {
+            free(bts);
+            sched_pt_destroy(&sched);
+            return -1;
+        }
+    }
+
+    pthread_t thread;
+    uint64_t start_us = micros64();
+    if (pthread_create(&thread, NULL, bench_thread, &sched) != 0) {
+        free(bts);
+        sched_pt_destroy(&sched);
+        return -1;
+    }
+    sleep_until_micros(start_us + (uint64_t)duration_ms * 1000);
+    sched_stop(&sched);
+    pthread_join(thread, NULL);
+    uint64_t elapsed_us = micros64() - start_us;
+
+    /* Merge the per-task histograms, each was only written by one worker at a time. */
+    static hist_t total;
+    hist_reset(&total);
+    for (size_t i = 0; i < tasks; i++) {
+        for (size_t b = 0; b < HIST_BUCKETS; b++) {
+            total.counts[b] += bts[i].latency.counts[b];
+        }
+        total.total += bts[i].latency.total;
+        if (bts[i].latency.max > total.max) {
+            total.max = bts[i].latency.max;
+        }
+    }
+
+    printf("%7zu %10llu %12.0f %10llu %10llu %10llu\n",
+        workers, (unsigned long long)total.total,
+        (double)total.total * 1e6 / (double)elapsed_us,
+        (unsigned long long)hist_percentile(&total, 50.0),
+        (unsigned long long)hist_percentile(&total, 99.0),
+        (unsigned long long)total.max);
+
+    free(bts);
+    sched_pt_destroy(&sched);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t duration_ms = 1000;
+    size_t   tasks       = 64;
+    uint32_t work_us     = 100;
+    if (argc > 1) {
+        duration_ms = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if (argc > 2) {
+        tasks = (size_t)strtoul(argv[2], NULL, 10);
+    }
+    if (argc > 3) {
+        work_us = (uint32_t)strtoul(argv[3], NULL, 10);
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t max_workers = cpus > 8 ? (size_t)cpus : 8;
+
+    system_init();
+    logger_enable(0);
+
+    printf("%zu tasks every %d ms, %u us of work each\n", tasks, BENCH_PERIOD_MS, work_us);
+    printf("%7s %10s %12s %10s %10s %10s\n", "workers", "runs", "runs/s", "p50_us", "p99_us", "max_us");
+    for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+        if (run(workers, tasks, work_us, duration_ms) != 0) {
+            fprintf(stderr, "bench_pt: failed to set up %zu workers\n", workers);
+            return 1;
+        }
+    }
+    return 0;
+}
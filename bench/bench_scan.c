@@ -0,0 +1,119 @@
+/**
+ * Scheduler due-check scan benchmark.
+ *
+ * Measures the per-tick cost of the linear backend, where every wakeup scans
+ * all tasks for due releases and for the next wakeup time. The scan is timed
+ * twice: once replaying the passes sched_tick() made over the task table
+ * before release times moved to the packed due-time array, and once through
+ * sched_tick() itself. Periods are long compared to the 1 ms synthetic tick,
+ * so almost every tick is pure scanning.
+ *
+ * Usage: rjos_bench_scan [ticks]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "scheduler.h"
+#include "system.h"
+
+static const uint32_t periods_ms[] = { 1000, 2000, 5000, 10000 };
+
+/** Keeps the results of the scans alive. */
+static volatile uint64_t sink;
+
+static void bench_task(void *data) {
+    (void)data;
+}
+
+/**
+ * Queue depth of the previous linear backend, counted over the task table.
+ */
+static size_t table_depth(const sched_t *sched) {
+    size_t depth = 0;
+    for (size_t i = 0; i < sched->order_count; i++) {
+        depth += sched->tasks[sched->order[i]].active;
+    }
+    return depth;
+}
+
+/**
+ * Linear-backend passes of the previous sched_tick(), which read the state
+ * and release time of every task from the task table: the batch bound, the
+ * due scan, the next release and the queue depth of the statistics. Due
+ * tasks are only counted, so the replay does less work than the loop did.
+ */
+static uint64_t table_tick(const sched_t *sched, uint64_t now_us) {
+    size_t depth = table_depth(sched);
+    size_t batch = 0;
+    for (size_t i = 0; i < sched->order_count && batch < depth; i++) {
+        const sched_task_t *task = &sched->tasks[sched->order[i]];
+        if (task->active && task->release_us <= now_us) {
+            batch++;
+        }
+    }
+    uint64_t next = UINT64_MAX;
+    for (size_t i = 0; i < sched->order_count; i++) {
+        const sched_task_t *task = &sched->tasks[sched->order[i]];
+        if (task->active && task->release_us < next) {
+            next = task->release_us;
+        }
+    }
+    return next + batch + table_depth(sched);
+}
+
+static int run(size_t tasks, uint32_t ticks) {
+    sched_t sched;
+    if (sched_init_backend(&sched, tasks, SCHED_BACKEND_LINEAR) != 0) {
+        return -1;
+    }
+    sched_set_histograms(&sched, 0);
+    srand(42);
+    for (size_t i = 0; i < tasks; i++) {
+        uint32_t period = periods_ms[(size_t)rand() % (sizeof(periods_ms) / sizeof(periods_ms[0]))];
+        if (sched_add_task(&sched, bench_task, NULL, period, (uint8_t)(i & 0xFF), "bench") != 0) {
+            sched_destroy(&sched);
+            return -1;
+        }
+    }
+    sched_prepare(&sched);
+
+    /* The replay only reads, so it scans the same state on every tick. */
+    uint64_t base_us = micros64();
+    uint64_t start_us = micros64();
+    for (uint32_t t = 1; t <= ticks; t++) {
+        sink = table_tick(&sched, base_us + (uint64_t)t * 1000);
+    }
+    uint64_t table_ns = (micros64() - start_us) * 1000;
+
+    start_us = micros64();
+    for (uint32_t t = 1; t <= ticks; t++) {
+        sink = sched_tick(&sched, base_us + (uint64_t)t * 1000);
+    }
+    uint64_t tick_ns = (micros64() - start_us) * 1000;
+
+    printf("%8zu %16.1f %16.1f\n", tasks, (double)table_ns / ticks, (double)tick_ns / ticks);
+
+    sched_destroy(&sched);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t ticks = 2000;
+    if (argc > 1) {
+        ticks = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    static const size_t counts[] = { 64, 256, 1024, 4096, 16384 };
+
+    system_init();
+    logger_enable(0);
+
+    printf("%8s %16s %16s\n", "tasks", "table ns/tick", "sched_tick ns");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        if (run(counts[c], ticks) != 0) {
+            fprintf(stderr, "bench_scan: failed to set up %zu tasks\n", counts[c]);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -6,6 +6,24 @@ int main(void) {
     /* Example logging a message. */
     logger_log(LOG_LEVEL_DEBUG, "This is a debug message.");
 
+    /* Call-site macros skip disabled messages without evaluating their arguments. */
+    LOG_DEBUG("This is a debug message from %s.", "a call site");
+    logger_enable_sites("pelco_d.c", 0, 1);
+
+    /* A storm of errors is cut down to a burst and a summary of what was suppressed. */
+    for (int i = 0; i < 1000; i++) {
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "Simulated fault %d.", i);
+        LOG_SAMPLED(LOG_LEVEL_INFO, 100, "Sampled event %d.", i);
+    }
+
+    /* Hand messages to a writer thread instead of writing them in place. */
+    if (logger_start_async(0, LOGGER_OVERFLOW_DROP) == 0) {
+        for (int i = 0; i < 10; i++) {
+            logger_log(LOG_LEVEL_INFO, "Asynchronous message %d.", i);
+        }
+        logger_stop_async();
+    }
+
     rjos_cleanup();
     return 0;
 }
\ No newline at end of file
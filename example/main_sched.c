@@ -27,22 +27,26 @@ int main(void) {
     rjos_init("config.txt", "log.txt");
 
     /* Scheduler initialization. */
-    sched_init(4);
+    sched_t sched;
+    sched_init(&sched, 4);
 
     /* Add tasks to the scheduler. */
-    sched_add_task(task_1hz1, NULL, 1000, 0, "task_1hz");
-    sched_add_task(task_1hz2, NULL, 1000, 0, "task_1hz");
-    sched_add_task(task_1hz3, NULL, 1000, 0, "task_1hz");
+    sched_add_task(&sched, task_1hz1, NULL, 1000, 0, "task_1hz");
+    sched_add_task(&sched, task_1hz2, NULL, 1000, 0, "task_1hz");
+    sched_add_task(&sched, task_1hz3, NULL, 1000, 0, "task_1hz");
+
+    /* Spread the 1 Hz tasks over the second instead of firing them in one tick. */
+    sched_set_stagger(&sched, 1);
 
     /* Setup scheduler log callback and signal handlers. */
-    sched_set_log_hook(NULL);
+    sched_set_log_hook(&sched, NULL);
     sched_setup_signal_handlers();
 
     /* Start the scheduler. */
-    sched_start();
+    sched_start(&sched);
 
     /* Release scheduler. */
-    sched_destroy();
+    sched_destroy(&sched);
 
     rjos_cleanup();
     return 0;
@@ -1,7 +1,43 @@
-/**
- * TODO: Rewrite scheduler_pt example.
- */
+#include <stdio.h>
+
+#include "rjos.h"
+#include "scheduler_pt.h"
+
+static void task_fast(void *args) {
+    (void)args;
+    printf("[%u ms] fast control task\n", millis());
+}
+
+static void task_slow(void *args) {
+    (void)args;
+    printf("[%u ms] slow housekeeping task\n", millis());
+}
 
 int main(void) {
+    rjos_init("config.txt", "log.txt");
+
+    /* Two independent schedulers: a control loop and a threaded housekeeping loop. */
+    sched_t control;
+    sched_t housekeeping;
+    sched_init(&control, 4);
+    sched_pt_init(&housekeeping, 4, 2);
+
+    sched_set_timing(&control, SCHED_TIMING_ABSOLUTE, SCHED_CATCHUP_SKIP);
+    sched_add_task(&control, task_fast, NULL, 100, 10, "control");
+    sched_add_task(&housekeeping, task_slow, NULL, 1000, 0, "housekeeping");
+
+    sched_setup_signal_handlers();
+
+    /* Run the control loop pinned to CPU 1 and the threaded scheduler on this thread. */
+    sched_start_thread(&control, 1);
+    sched_pt_start(&housekeeping);
+
+    sched_stop(&control);
+    sched_join(&control);
+
+    sched_destroy(&control);
+    sched_pt_destroy(&housekeeping);
+
+    rjos_cleanup();
     return 0;
 }
@@ -1,7 +1,30 @@
 #include "logger.h"
+#include "system.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdarg.h>
 #include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/** Maximum number of records written by one writev() call. */
+#define LOGGER_BATCH 64
+
+/** Size of a rendered timestamp, including the terminating null byte. */
+#define LOGGER_TIME_SIZE 32
+
+/** Longest sleep of the writer thread between two wakeups. */
+#define LOGGER_WRITER_IDLE_US 10000
+
+/*
+ * Records of the binary log, in host byte order:
+ *   'H' "RJOSBIN" u32 0x01020304, u64 wall-clock microseconds at micros64() == 0
+ *   'S' u32 site, u8 level, u16 length, format
+ *   'E' u32 site, u64 micros64(), u16 length, arguments (see log_format_pack())
+ */
+#define LOGGER_BIN_HEADER   20
+#define LOGGER_BIN_EVENT    15
 
 /**
  * @brief A static global logger instance used for logging purposes throughout the application.
@@ -10,7 +33,378 @@
  * on the logger and can be used as a shared resource for logging in a multithreaded
  * application.
  */
-static logger_t glog = { NULL, LOG_LEVEL_DEBUG, 1, PTHREAD_MUTEX_INITIALIZER };
+static logger_t glog = {
+    .file      = NULL,
+    .log_level = LOG_LEVEL_DEBUG,
+    .enabled   = 1,
+    .mutex     = PTHREAD_MUTEX_INITIALIZER,
+    .bin_fd    = -1,
+    .site_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+#if defined(__ELF__)
+/* Bounds of the section listing the call sites, set by the linker. */
+extern logger_site_t *const __start_rjos_log_sites[] __attribute__((weak));
+extern logger_site_t *const __stop_rjos_log_sites[] __attribute__((weak));
+#endif
+
+const char *logger_level_name(int level) {
+    switch (level) {
+        case LOG_LEVEL_DEBUG:
+            return "DEBUG";
+        case LOG_LEVEL_INFO:
+            return "INFO";
+        case LOG_LEVEL_WARN:
+            return "WARN";
+        case LOG_LEVEL_ERROR:
+            return "ERROR";
+        default:
+            return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Date and time of the current second, rendered once per second and thread.
+ */
+static _Thread_local struct {
+    uint64_t second;
+    size_t   len;
+    char     text[LOGGER_TIME_SIZE];
+} time_cache;
+
+/**
+ * @brief Writes a number in decimal, zero-padded to the given width.
+ *
+ * @return Number of characters written.
+ */
+static size_t put_decimal(char *buf, uint64_t value, size_t width) {
+    char digits[20];
+    size_t n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0 || n < width);
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+/**
+ * @brief Renders the timestamp of a log line with microsecond resolution.
+ * @details Reads only the clock of micros64(). The wall-clock date is
+ * rendered when the second changes, which is also when the offset to the
+ * wall clock is measured again.
+ *
+ * @param buf Receives the timestamp, LOGGER_TIME_SIZE bytes.
+ */
+static void format_time(char *buf) {
+    size_t len;
+    uint64_t now_us;
+    if (atomic_load_explicit(&glog.time_format, memory_order_relaxed) == LOGGER_TIME_MONOTONIC) {
+        now_us = micros64();
+        len = put_decimal(buf, now_us / 1000000, 1);
+    } else {
+        now_us = wall_micros64();
+        uint64_t second = now_us / 1000000;
+        if (second != time_cache.second || time_cache.len == 0) {
+            system_sync_wall_clock();
+            now_us = wall_micros64();
+            second = now_us / 1000000;
+            time_t seconds = (time_t)second;
+            struct tm local_time;
+            if (localtime_r(&seconds, &local_time)) {
+                time_cache.len = strftime(time_cache.text, sizeof(time_cache.text), "%Y-%m-%d %H:%M:%S", &local_time);
+            } else {
+                time_cache.len = (size_t)snprintf(time_cache.text, sizeof(time_cache.text), "UNKNOWN TIME");
+            }
+            time_cache.second = second;
+        }
+        memcpy(buf, time_cache.text, time_cache.len);
+        len = time_cache.len;
+    }
+    buf[len++] = '.';
+    len += put_decimal(buf + len, now_us % 1000000, 6);
+    buf[len] = '\0';
+}
+
+/**
+ * @brief Formats a complete log line, truncated to the buffer.
+ *
+ * @return Length of the line, including the final newline.
+ */
+static size_t format_record(char *buf, size_t size, int level, const char *format, va_list args) {
+    char time_str[LOGGER_TIME_SIZE];
+    format_time(time_str);
+    /* Keep the last byte for the newline. */
+    int n = snprintf(buf, size - 1, "[%s] %s: ", time_str, logger_level_name(level));
+    size_t len = n < 0 ? 0 : ((size_t)n < size - 1 ? (size_t)n : size - 2);
+    n = vsnprintf(buf + len, size - 1 - len, format, args);
+    if (n > 0) {
+        len += (size_t)n < size - 1 - len ? (size_t)n : size - 2 - len;
+    }
+    buf[len++] = '\n';
+    return len;
+}
+
+/**
+ * @brief Wakes the writer thread.
+ */
+static void wake_writer(void) {
+    atomic_fetch_add(&glog.wake_seq, 1);
+    wake_waiters(&glog.wake_seq);
+}
+
+/**
+ * @brief Claims a record of a ring, applying the overflow policy when it is full.
+ *
+ * @param block Non-zero to wait for a free record regardless of the policy.
+ * @return Pointer to the record, or NULL if the message is dropped.
+ */
+static char *claim_record(log_ring_t *ring, size_t *pos, int block) {
+    char *record = log_ring_claim(ring, pos);
+    if (!record) {
+        if (!block && glog.overflow == LOGGER_OVERFLOW_DROP) {
+            atomic_fetch_add(&glog.dropped, 1);
+            return NULL;
+        }
+        /* Sleep rather than yield, so a writer of lower priority gets the CPU. */
+        atomic_fetch_add(&glog.blocked, 1);
+        do {
+            wake_writer();
+            sleep_until_micros(micros64() + 100);
+        } while (!(record = log_ring_claim(ring, pos)));
+    }
+    return record;
+}
+
+/**
+ * @brief Publishes a record, waking the writer thread once per batch.
+ * @details A wakeup costs a system call, so the records in between wait at
+ * most LOGGER_WRITER_IDLE_US for the writer thread to poll the ring.
+ */
+static void publish_record(log_ring_t *ring, size_t pos, size_t len) {
+    log_ring_publish(ring, pos, len);
+    if (pos % LOGGER_BATCH == LOGGER_BATCH - 1) {
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load(&glog.sleeping)) {
+            wake_writer();
+        }
+    }
+}
+
+/**
+ * @brief Formats a message into the ring of the writer thread.
+ */
+static void log_async(int level, const char *format, va_list args) {
+    size_t pos;
+    char *record = claim_record(&glog.ring, &pos, 0);
+    if (record) {
+        publish_record(&glog.ring, pos, format_record(record, LOG_RING_RECORD_SIZE, level, format, args));
+    }
+}
+
+/**
+ * @brief Parses the format of a site and writes its definition to the binary log.
+ * @details Runs once per site and binary log file. The definition is queued
+ * before any message of the site, as the site only becomes current after it.
+ */
+static void register_site(logger_site_t *site, unsigned gen) {
+    pthread_mutex_lock(&glog.site_mutex);
+    if (atomic_load(&site->gen) != gen) {
+        size_t format_len = strlen(site->format);
+        if (atomic_load(&site->id) == 0) {
+            int count = log_format_parse(site->format, site->types, LOG_FORMAT_MAX_ARGS);
+            site->text  = count < 0 || format_len > LOG_RING_RECORD_SIZE - 8;
+            site->count = (uint8_t)(count < 0 ? 0 : count);
+            atomic_store(&site->id, ++glog.site_count);
+        }
+        if (!site->text) {
+            size_t pos;
+            char *record = claim_record(&glog.bin_ring, &pos, 1);
+            uint32_t id = atomic_load(&site->id);
+            uint8_t level = (uint8_t)site->level;
+            uint16_t len = (uint16_t)format_len;
+            record[0] = 'S';
+            memcpy(record + 1, &id, sizeof(id));
+            memcpy(record + 5, &level, sizeof(level));
+            memcpy(record + 6, &len, sizeof(len));
+            memcpy(record + 8, site->format, len);
+            publish_record(&glog.bin_ring, pos, 8 + (size_t)len);
+        }
+        atomic_store(&site->gen, gen);
+    }
+    pthread_mutex_unlock(&glog.site_mutex);
+}
+
+/**
+ * @brief Stores a message of a site as a binary record.
+ *
+ * @return Returns 0 if the message was handled, or -1 if it has to be
+ *         formatted as text, in which case args was not used.
+ */
+static int log_binary(logger_site_t *site, va_list args) {
+    unsigned gen = atomic_load(&glog.bin_gen);
+    if (atomic_load(&site->gen) != gen) {
+        register_site(site, gen);
+    }
+    if (site->text) {
+        return -1;
+    }
+    size_t pos;
+    char *record = claim_record(&glog.bin_ring, &pos, 0);
+    if (record) {
+        uint32_t id = atomic_load_explicit(&site->id, memory_order_relaxed);
+        uint64_t now_us = micros64();
+        uint16_t len = (uint16_t)log_format_pack((uint8_t *)record + LOGGER_BIN_EVENT,
+            LOG_RING_RECORD_SIZE - LOGGER_BIN_EVENT, site->types, site->count, args);
+        record[0] = 'E';
+        memcpy(record + 1, &id, sizeof(id));
+        memcpy(record + 5, &now_us, sizeof(now_us));
+        memcpy(record + 13, &len, sizeof(len));
+        publish_record(&glog.bin_ring, pos, LOGGER_BIN_EVENT + (size_t)len);
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes a batch of records to a descriptor, resuming partial writes.
+ */
+static void write_records(int fd, struct iovec *iov, size_t count) {
+    atomic_fetch_add(&glog.written, count);
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, (int)count);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("logger: writev");
+            break;
+        }
+        atomic_fetch_add(&glog.writes, 1);
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+}
+
+/**
+ * @brief Gathers published records of a ring into a batch.
+ *
+ * @return Number of records in the batch.
+ */
+static size_t gather_records(log_ring_t *ring, struct iovec *iov) {
+    size_t count = 0;
+    size_t len;
+    const char *record;
+    while (count < LOGGER_BATCH && (record = log_ring_peek(ring, count, &len))) {
+        iov[count].iov_base = (void *)record;
+        iov[count].iov_len  = len;
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Writer thread of the asynchronous mode.
+ * @details Writes the records in place from the ring and releases them
+ * afterwards. When the ring is empty the thread blocks on a futex, woken by
+ * callers that find it asleep, with a timeout as a safety net.
+ */
+static void *writer_thread(void *arg) {
+    (void)arg;
+    struct iovec iov[LOGGER_BATCH];
+    for (;;) {
+        size_t count = gather_records(&glog.ring, iov);
+        if (count > 0) {
+            pthread_mutex_lock(&glog.mutex);
+            if (glog.file) {
+                fflush(glog.file);
+                write_records(fileno(glog.file), iov, count);
+            }
+            pthread_mutex_unlock(&glog.mutex);
+            log_ring_release(&glog.ring, count);
+        }
+        int bin_fd = atomic_load(&glog.bin_fd);
+        size_t bin_count = bin_fd >= 0 ? gather_records(&glog.bin_ring, iov) : 0;
+        if (bin_count > 0) {
+            write_records(bin_fd, iov, bin_count);
+            log_ring_release(&glog.bin_ring, bin_count);
+        }
+        if (count > 0 || bin_count > 0) {
+            continue;
+        }
+        if (atomic_load(&glog.stopping)) {
+            break;
+        }
+        unsigned seq = atomic_load(&glog.wake_seq);
+        atomic_store(&glog.sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        size_t len;
+        if (!log_ring_peek(&glog.ring, 0, &len) && !(bin_fd >= 0 && log_ring_peek(&glog.bin_ring, 0, &len)) &&
+            !atomic_load(&glog.stopping)) {
+            wait_until_micros(micros64() + LOGGER_WRITER_IDLE_US, &glog.wake_seq, seq);
+        }
+        atomic_store(&glog.sleeping, 0);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Checks whether a site is in a file given by trailing path components.
+ */
+static int site_in_file(const logger_site_t *site, const char *file) {
+    size_t len = strlen(file);
+    size_t site_len = strlen(site->file);
+    if (len > site_len || strcmp(site->file + site_len - len, file) != 0) {
+        return 0;
+    }
+    return len == site_len || site->file[site_len - len - 1] == '/';
+}
+
+/**
+ * @brief Recomputes whether the call sites reach the logger.
+ * @details Called with the mutex held whenever the level, the state of the
+ * logger or the switch of a site changes.
+ */
+static void update_sites(void) {
+#if defined(__ELF__)
+    int level = atomic_load(&glog.log_level);
+    int enabled = atomic_load(&glog.enabled);
+    for (logger_site_t *const *ref = __start_rjos_log_sites; ref < __stop_rjos_log_sites; ref++) {
+        logger_site_t *site = *ref;
+        atomic_store_explicit(&site->active, enabled && site->level >= level && atomic_load(&site->enabled),
+            memory_order_relaxed);
+    }
+#endif
+}
+
+int logger_enable_sites(const char *file, int line, int enabled) {
+    int count = 0;
+    pthread_mutex_lock(&glog.mutex);
+#if defined(__ELF__)
+    for (logger_site_t *const *ref = __start_rjos_log_sites; ref < __stop_rjos_log_sites; ref++) {
+        logger_site_t *site = *ref;
+        if ((!file || site_in_file(site, file)) && (line == 0 || site->line == line)) {
+            atomic_store(&site->enabled, enabled != 0);
+            count++;
+        }
+    }
+    update_sites();
+#else
+    (void)file;
+    (void)line;
+    (void)enabled;
+#endif
+    pthread_mutex_unlock(&glog.mutex);
+    return count;
+}
 
 int logger_init(char *filename, int log_level) {
     pthread_mutex_lock(&glog.mutex);
@@ -26,8 +420,9 @@ int logger_init(char *filename, int log_level) {
         pthread_mutex_unlock(&glog.mutex);
         return -1;
     }
-    glog.log_level = log_level;
-    glog.enabled   = 1;
+    atomic_store(&glog.log_level, log_level);
+    atomic_store(&glog.enabled, 1);
+    update_sites();
     pthread_mutex_unlock(&glog.mutex);
 
     return 0;
@@ -35,57 +430,56 @@ int logger_init(char *filename, int log_level) {
 
 void logger_set_log_level(int log_level) {
     pthread_mutex_lock(&glog.mutex);
-    glog.log_level = log_level;
+    atomic_store(&glog.log_level, log_level);
+    update_sites();
     pthread_mutex_unlock(&glog.mutex);
 }
 
+void logger_set_time_format(logger_time_t format) {
+    atomic_store(&glog.time_format, format);
+}
+
 void logger_enable(int enabled) {
     pthread_mutex_lock(&glog.mutex);
-    glog.enabled = enabled;
+    atomic_store(&glog.enabled, enabled);
+    update_sites();
     pthread_mutex_unlock(&glog.mutex);
 }
 
-void logger_log(int level, const char *format, ...) {
-    if (level < glog.log_level || !glog.enabled) {
-        return;
+/**
+ * @brief Checks the level of a message against the logger.
+ */
+static int level_enabled(int level) {
+    return level >= RJOS_LOG_MIN_LEVEL &&
+        level >= atomic_load_explicit(&glog.log_level, memory_order_relaxed) &&
+        atomic_load_explicit(&glog.enabled, memory_order_relaxed);
+}
+
+/**
+ * @brief Logs a message that passed the level check.
+ */
+static void log_text(int level, const char *format, va_list args) {
+    if (atomic_load(&glog.async)) {
+        /* Announce the caller before checking again, so logger_stop_async() waits for it. */
+        atomic_fetch_add(&glog.callers, 1);
+        if (atomic_load(&glog.async)) {
+            log_async(level, format, args);
+            atomic_fetch_sub(&glog.callers, 1);
+            return;
+        }
+        atomic_fetch_sub(&glog.callers, 1);
     }
     pthread_mutex_lock(&glog.mutex);
 
     /* Add a timestamp to the log. */
-    time_t now = time(NULL);
-    struct tm *local_time = localtime(&now);
-    char time_str[32];
-    if (local_time) {
-        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", local_time);
-    } else {
-        strncpy(time_str, "UNKNOWN TIME", sizeof(time_str));
-    }
+    char time_str[LOGGER_TIME_SIZE];
+    format_time(time_str);
 
     /* Write a log message. */
     if (glog.file) {
-        fprintf(glog.file, "[%s] ", time_str);
-        switch (level) {
-            case LOG_LEVEL_DEBUG:
-                fprintf(glog.file, "DEBUG: ");
-                break;
-            case LOG_LEVEL_INFO:
-                fprintf(glog.file, "INFO: ");
-                break;
-            case LOG_LEVEL_WARN:
-                fprintf(glog.file, "WARN: ");
-                break;
-            case LOG_LEVEL_ERROR:
-                fprintf(glog.file, "ERROR: ");
-                break;
-            default:
-                fprintf(glog.file, "UNKNOWN: ");
-                break;
-        }
+        fprintf(glog.file, "[%s] %s: ", time_str, logger_level_name(level));
         /* Format the user-provided message. */
-        va_list args;
-        va_start(args, format);
         vfprintf(glog.file, format, args);
-        va_end(args);
 
         /* Ensure logs are immediately written to the file. */
         fprintf(glog.file, "\n");
@@ -94,7 +488,147 @@ void logger_log(int level, const char *format, ...) {
     pthread_mutex_unlock(&glog.mutex);
 }
 
+void logger_log(int level, const char *format, ...) {
+    if (!level_enabled(level)) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    log_text(level, format, args);
+    va_end(args);
+}
+
+int logger_site_limit(logger_site_t *site) {
+    /* Token bucket kept as the time at which it is full again, a single word updated by CAS. */
+    uint64_t now_us = micros64();
+    uint64_t next_us = atomic_load_explicit(&site->next_us, memory_order_relaxed);
+    for (;;) {
+        uint64_t from_us = next_us > now_us ? next_us : now_us;
+        if (from_us - now_us > site->burst_us) {
+            atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+            return 0;
+        }
+        if (atomic_compare_exchange_weak_explicit(&site->next_us, &next_us, from_us + site->interval_us,
+                memory_order_relaxed, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+}
+
+void logger_log_site(logger_site_t *site, const char *format, ...) {
+    if (!level_enabled(site->level)) {
+        return;
+    }
+    unsigned suppressed;
+    if (atomic_load_explicit(&site->suppressed, memory_order_relaxed) &&
+        (suppressed = atomic_exchange_explicit(&site->suppressed, 0, memory_order_relaxed)) > 0) {
+        logger_log(site->level, "Suppressed %u messages: %s", suppressed, site->format);
+    }
+    va_list args;
+    va_start(args, format);
+    if (atomic_load(&glog.binary)) {
+        atomic_fetch_add(&glog.callers, 1);
+        if (atomic_load(&glog.binary) && log_binary(site, args) == 0) {
+            atomic_fetch_sub(&glog.callers, 1);
+            va_end(args);
+            return;
+        }
+        atomic_fetch_sub(&glog.callers, 1);
+    }
+    log_text(site->level, format, args);
+    va_end(args);
+}
+
+int logger_start_async(size_t capacity, logger_overflow_t overflow) {
+    pthread_mutex_lock(&glog.mutex);
+    if (atomic_load(&glog.async)) {
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+    if (log_ring_init(&glog.ring, capacity ? capacity : LOGGER_ASYNC_CAPACITY) != 0) {
+        perror("logger_start_async: malloc");
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+    glog.overflow = overflow;
+    atomic_store(&glog.stopping, 0);
+    atomic_store(&glog.sleeping, 0);
+    if (pthread_create(&glog.writer, NULL, writer_thread, NULL) != 0) {
+        perror("logger_start_async: pthread_create");
+        log_ring_destroy(&glog.ring);
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+    atomic_store(&glog.async, 1);
+    pthread_mutex_unlock(&glog.mutex);
+    return 0;
+}
+
+int logger_start_binary(const char *filename) {
+    pthread_mutex_lock(&glog.mutex);
+    if (!atomic_load(&glog.async) || atomic_load(&glog.bin_fd) >= 0) {
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+    int fd = open(filename, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("logger_start_binary: open");
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+
+    /* Anchor the monotonic timestamps of the records to the wall clock. */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t wall_us = (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000 - micros64();
+    char header[LOGGER_BIN_HEADER];
+    uint32_t order = 0x01020304;
+    header[0] = 'H';
+    memcpy(header + 1, "RJOSBIN", 7);
+    memcpy(header + 8, &order, sizeof(order));
+    memcpy(header + 12, &wall_us, sizeof(wall_us));
+    if (write(fd, header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        log_ring_init(&glog.bin_ring, glog.ring.mask + 1) != 0) {
+        perror("logger_start_binary: write");
+        close(fd);
+        pthread_mutex_unlock(&glog.mutex);
+        return -1;
+    }
+    atomic_store(&glog.bin_fd, fd);
+    atomic_fetch_add(&glog.bin_gen, 1);
+    atomic_store(&glog.binary, 1);
+    pthread_mutex_unlock(&glog.mutex);
+    return 0;
+}
+
+void logger_stop_async(void) {
+    atomic_store(&glog.binary, 0);
+    if (!atomic_exchange(&glog.async, 0)) {
+        return;
+    }
+    /* Let the callers that saw asynchronous mode publish their record. */
+    while (atomic_load(&glog.callers) > 0) {
+        sleep_until_micros(micros64() + 50);
+    }
+    atomic_store(&glog.stopping, 1);
+    wake_writer();
+    pthread_join(glog.writer, NULL);
+    log_ring_destroy(&glog.ring);
+    if (atomic_load(&glog.bin_fd) >= 0) {
+        close(atomic_exchange(&glog.bin_fd, -1));
+        log_ring_destroy(&glog.bin_ring);
+    }
+}
+
+void logger_get_stats(logger_stats_t *stats) {
+    stats->written = atomic_load(&glog.written);
+    stats->dropped = atomic_load(&glog.dropped);
+    stats->blocked = atomic_load(&glog.blocked);
+    stats->writes  = atomic_load(&glog.writes);
+}
+
 void logger_destroy(void) {
+    logger_stop_async();
     pthread_mutex_lock(&glog.mutex);
     if (glog.file) {
         fclose(glog.file);
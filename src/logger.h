@@ -2,26 +2,219 @@
 #define RJOS_LOGGER_H
 
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 
+#include "util/log_format.h"
+#include "util/log_ring.h"
+
 #define LOG_LEVEL_DEBUG 0
 #define LOG_LEVEL_INFO  1
 #define LOG_LEVEL_WARN  2
 #define LOG_LEVEL_ERROR 3
 
+/** Default rate limit of error paths, in messages per second, see LOG_RATELIMITED(). */
+#define LOGGER_RATE     10
+
+/** Default burst of error paths, in messages, see LOG_RATELIMITED(). */
+#define LOGGER_BURST    20
+
+/** Default number of records buffered in asynchronous mode. */
+#define LOGGER_ASYNC_CAPACITY 1024
+
+/**
+ * @brief What a caller does when the asynchronous ring is full.
+ */
+typedef enum logger_overflow {
+    LOGGER_OVERFLOW_DROP,   /**< Discard the message and count it */
+    LOGGER_OVERFLOW_BLOCK,  /**< Wait for the writer thread to free a record */
+} logger_overflow_t;
+
+/**
+ * @brief Clock of the timestamps of log lines.
+ */
+typedef enum logger_time {
+    LOGGER_TIME_WALL,       /**< Local date and time, e.g. "2024-05-01 12:00:00.000250" */
+    LOGGER_TIME_MONOTONIC,  /**< Seconds on the micros64() timeline, e.g. "12.000250" */
+} logger_time_t;
+
+/**
+ * @brief Counters of the asynchronous mode.
+ */
+typedef struct logger_stats {
+    uint64_t written;       /**< Records handed to the file by the writer thread */
+    uint64_t dropped;       /**< Messages discarded because the ring was full */
+    uint64_t blocked;       /**< Messages whose caller had to wait for a free record */
+    uint64_t writes;        /**< writev() calls issued by the writer thread */
+} logger_stats_t;
+
+/**
+ * @brief Lowest level compiled into LOG_DEBUG() and friends.
+ *
+ * Calls below it expand to nothing, their arguments are never evaluated.
+ * Set it for the whole build, e.g. -DRJOS_LOG_MIN_LEVEL=1 to drop debug
+ * messages.
+ */
+#ifndef RJOS_LOG_MIN_LEVEL
+#define RJOS_LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/**
+ * @brief A log call site.
+ *
+ * Declared static at the call site by LOG_DEBUG() and friends. The call only
+ * reaches the logger while the site is active, which combines the runtime
+ * switch of the site with the level and state of the logger, so a disabled
+ * site costs one load and a branch. For the binary log, the format string is
+ * parsed and written once on first use, after which a call only stores the
+ * site number, a timestamp and the raw argument values.
+ */
+typedef struct logger_site {
+    const char *format;
+    const char *file;
+    int         line;
+    int         level;
+    atomic_int  active;     /**< Non-zero if calls of the site reach the logger */
+    atomic_int  enabled;    /**< Runtime switch of the site, see logger_enable_sites() */
+    atomic_uint id;         /**< Number of the site in the binary log, 0 until first use */
+    atomic_uint gen;        /**< Binary log the definition of the site was written to */
+    int         text;       /**< Non-zero if the format has to be formatted as text */
+    uint8_t     count;      /**< Number of arguments */
+    uint8_t     types[LOG_FORMAT_MAX_ARGS];
+    uint32_t    interval_us;    /**< Rate limit: time to earn one message, 0 if unlimited */
+    uint32_t    burst_us;       /**< Rate limit: how far ahead of time messages may run */
+    uint32_t    sample;         /**< Sampling: log one message in sample, 0 to log all */
+    _Atomic uint64_t next_us;   /**< Rate limit: earliest time at which the bucket is full again */
+    atomic_uint seen;           /**< Sampling: messages of the site so far */
+    atomic_uint suppressed;     /**< Messages dropped by the rate limit since the last summary */
+} logger_site_t;
+
+#define LOGGER_FIRST_(first, ...) first
+
+/* Lists every site in a linker section, so the logger can update them all. */
+#if defined(__ELF__)
+#define LOGGER_LIST_SITE_(site) \
+        static logger_site_t *const logger_site_ref_ __attribute__((section("rjos_log_sites"), used)) = &(site)
+#else
+#define LOGGER_LIST_SITE_(site) (void)0
+#endif
+
+#define LOGGER_UNWRAP_(...) __VA_ARGS__
+
+#define LOGGER_SITE_(site_level, on, limit, ...) do { \
+        static logger_site_t logger_site_ = { .format = LOGGER_FIRST_(__VA_ARGS__, 0), .file = __FILE__, \
+            .line = __LINE__, .level = (site_level), .active = (on), .enabled = (on), LOGGER_UNWRAP_ limit }; \
+        LOGGER_LIST_SITE_(logger_site_); \
+        if ((site_level) >= RJOS_LOG_MIN_LEVEL && \
+            atomic_load_explicit(&logger_site_.active, memory_order_relaxed) && \
+            logger_site_admit(&logger_site_)) { \
+            logger_log_site(&logger_site_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+/* Type checks the arguments without evaluating them. */
+#define LOGGER_DISCARD_(level, ...) do { \
+        if (0) { \
+            logger_log((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+/**
+ * @brief Logs a message through a static call site.
+ *
+ * Usage: LOG_INFO("Task %s took %u us.", name, duration_us);
+ * The format must be a string literal. LOG_TRACE() logs at debug level from
+ * a site that starts disabled, for hot paths that are enabled on demand with
+ * logger_enable_sites().
+ */
+#if RJOS_LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...)  LOGGER_SITE_(LOG_LEVEL_DEBUG, 1, (), __VA_ARGS__)
+#define LOG_TRACE(...)  LOGGER_SITE_(LOG_LEVEL_DEBUG, 0, (), __VA_ARGS__)
+#else
+#define LOG_DEBUG(...)  LOGGER_DISCARD_(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_TRACE(...)  LOGGER_DISCARD_(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#endif
+#if RJOS_LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...)   LOGGER_SITE_(LOG_LEVEL_INFO, 1, (), __VA_ARGS__)
+#else
+#define LOG_INFO(...)   LOGGER_DISCARD_(LOG_LEVEL_INFO, __VA_ARGS__)
+#endif
+#if RJOS_LOG_MIN_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...)   LOGGER_SITE_(LOG_LEVEL_WARN, 1, (), __VA_ARGS__)
+#else
+#define LOG_WARN(...)   LOGGER_DISCARD_(LOG_LEVEL_WARN, __VA_ARGS__)
+#endif
+#if RJOS_LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...)  LOGGER_SITE_(LOG_LEVEL_ERROR, 1, (), __VA_ARGS__)
+#else
+#define LOG_ERROR(...)  LOGGER_DISCARD_(LOG_LEVEL_ERROR, __VA_ARGS__)
+#endif
+
+/**
+ * @brief Logs a message of a variable level through a static call site.
+ *
+ * Messages of a LOG_BIN() site go to the binary log while it is open, as do
+ * those of LOG_DEBUG() and friends. Formats with '*' widths, %n or wide
+ * strings are always formatted as text.
+ */
+#define LOG_BIN(level, ...) LOGGER_SITE_((level), 1, (), __VA_ARGS__)
+
+/**
+ * @brief Logs at most rate messages per second from a call site.
+ *
+ * The site is a token bucket holding up to burst messages, refilled at rate
+ * messages per second. Messages beyond it are dropped before their arguments
+ * are evaluated; their number is logged ahead of the next message that
+ * passes. For error paths that may fire in storms.
+ *
+ * Usage: LOG_RATELIMITED(LOG_LEVEL_ERROR, 10, 20, "Read failed: %s.", strerror(errno));
+ * Rate and burst must be constants, at least 1.
+ */
+#define LOG_RATELIMITED(level, rate, burst, ...) LOGGER_SITE_((level), 1, \
+        (.interval_us = 1000000 / (rate), .burst_us = 1000000 / (rate) * ((burst) - 1)), __VA_ARGS__)
+
+/**
+ * @brief Logs the first and then one in n messages of a call site.
+ *
+ * Usage: LOG_SAMPLED(LOG_LEVEL_DEBUG, 100, "Frame %u received.", seq);
+ */
+#define LOG_SAMPLED(level, n, ...) LOGGER_SITE_((level), 1, (.sample = (n)), __VA_ARGS__)
+
 /**
  * @struct logger
  * @brief A structure for managing logging functionality.
  *
  * The logger structure is designed to handle log file operations, manage the
  * log level, and enable or disable logging functionality. It provides
- * thread-safe operations by incorporating a mutex for synchronization.
+ * thread-safe operations by incorporating a mutex for synchronization. In
+ * asynchronous mode, callers format into a lock-free ring instead and a
+ * writer thread batches the records into writev() calls.
  */
 typedef struct logger {
     FILE *file;
-    int log_level;
-    int enabled;
+    atomic_int log_level;
+    atomic_int enabled;
+    atomic_int time_format;     /**< logger_time_t of the timestamps */
     pthread_mutex_t mutex;
+    log_ring_t ring;            /**< Records waiting for the writer thread */
+    pthread_t writer;
+    logger_overflow_t overflow;
+    atomic_int async;           /**< Non-zero while callers hand records to the writer thread */
+    atomic_int callers;         /**< Callers currently filling a record */
+    atomic_int stopping;
+    atomic_int sleeping;        /**< Non-zero while the writer thread may be blocked */
+    atomic_uint wake_seq;       /**< Bumped to wake the writer thread */
+    log_ring_t bin_ring;        /**< Binary records waiting for the writer thread */
+    atomic_int bin_fd;          /**< Binary log file, -1 if closed */
+    atomic_int binary;          /**< Non-zero while LOG_BIN() writes binary records */
+    atomic_uint bin_gen;        /**< Bumped for each binary log file */
+    unsigned site_count;
+    pthread_mutex_t site_mutex; /**< Serializes the registration of call sites */
+    _Atomic uint64_t written;
+    _Atomic uint64_t dropped;
+    _Atomic uint64_t blocked;
+    _Atomic uint64_t writes;
 } logger_t;
 
 /**
@@ -48,6 +241,17 @@ int logger_init(char *filename, int log_level);
  */
 void logger_set_log_level(int log_level);
 
+/**
+ * @brief Selects the clock of the timestamps of log lines.
+ *
+ * Timestamps have microsecond resolution. Wall-clock time, the default, is
+ * derived from the clock of micros64(); monotonic time is micros64() itself,
+ * so log lines can be lined up with scheduler timestamps and statistics.
+ *
+ * @param format The clock of the timestamps.
+ */
+void logger_set_time_format(logger_time_t format);
+
 /**
  * @brief Enables or disables logging functionality.
  *
@@ -73,11 +277,102 @@ void logger_enable(int enabled);
  */
 void logger_log(int level, const char *format, ...);
 
+/**
+ * @brief Switches the logger to asynchronous mode.
+ *
+ * Callers then format their message into a bounded lock-free ring and return
+ * without touching the file; a background thread writes the records in
+ * batches with writev(). Messages longer than LOG_RING_RECORD_SIZE are
+ * truncated. When the ring is full, the message is dropped or the caller
+ * waits, according to the overflow policy.
+ *
+ * @param capacity Number of records of the ring, 0 for LOGGER_ASYNC_CAPACITY.
+ * @param overflow What callers do when the ring is full.
+ * @return Returns 0 on success, or -1 if asynchronous mode is already on or
+ *         the ring or the thread cannot be created.
+ */
+int logger_start_async(size_t capacity, logger_overflow_t overflow);
+
+/**
+ * @brief Writes the pending records and returns to synchronous mode.
+ */
+void logger_stop_async(void);
+
+/**
+ * @brief Reads the counters of the asynchronous mode.
+ *
+ * @param stats Receives the counters, accumulated since the program started.
+ */
+void logger_get_stats(logger_stats_t *stats);
+
+/**
+ * @brief Starts writing LOG_BIN() messages to a binary log file.
+ *
+ * The messages are formatted later, by the rjos_logdecode tool, which turns
+ * the file back into the text format of the log. Requires asynchronous mode;
+ * the file is closed by logger_stop_async(). Each start appends a header, so
+ * a file may hold several runs.
+ *
+ * @param filename The binary log file, created or appended to.
+ * @return Returns 0 on success, or -1 if asynchronous mode is off, a binary
+ *         log is already open or the file cannot be opened.
+ */
+int logger_start_binary(const char *filename);
+
+/**
+ * @brief Enables or disables call sites of LOG_DEBUG() and friends.
+ *
+ * A disabled site skips the logger without evaluating its arguments,
+ * whatever the log level.
+ *
+ * @param file Path or trailing path components of the source file, e.g.
+ *        "pelco_d.c", or NULL for all files.
+ * @param line Line of the call site, or 0 for all sites of the file.
+ * @param enabled Non-zero to enable the sites, zero to disable them.
+ * @return Number of call sites matched.
+ */
+int logger_enable_sites(const char *file, int line, int enabled);
+
+/**
+ * @brief Takes a token from the bucket of a rate-limited site, see LOG_RATELIMITED().
+ *
+ * @param site The call site.
+ * @return Non-zero if the message may be logged, 0 if it is suppressed.
+ */
+int logger_site_limit(logger_site_t *site);
+
+/**
+ * @brief Checks the rate limit or sampling of a call site.
+ *
+ * @param site The call site.
+ * @return Non-zero if the message may be logged.
+ */
+static inline int logger_site_admit(logger_site_t *site) {
+    if (site->sample) {
+        return atomic_fetch_add_explicit(&site->seen, 1, memory_order_relaxed) % site->sample == 0;
+    }
+    return site->interval_us == 0 || logger_site_limit(site);
+}
+
+/**
+ * @brief Logs a message of a call site, see LOG_DEBUG().
+ *
+ * @param site The call site.
+ * @param format The format string of the site.
+ * @param ... Additional arguments corresponding to the format string.
+ */
+void logger_log_site(logger_site_t *site, const char *format, ...);
+
+/**
+ * @brief Returns the name printed for a log level, e.g. "INFO".
+ */
+const char *logger_level_name(int level);
+
 /**
  * @brief Cleans up and releases the resources associated with the logger.
  *
  * This function ensures that all resources held by the global logger are properly
- * deallocated. It closes the log file if it is open, resets the associated file pointer
+ * deallocated. It stops asynchronous mode, closes the log file if it is open, resets the associated file pointer
  * to NULL, and destroys the mutex used for thread synchronization. It provides a safe
  * and consistent way to clean up the logging system before application termination.
  */
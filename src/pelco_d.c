@@ -1,4 +1,5 @@
 #include "pelco_d.h"
+#include "logger.h"
 
 /**
  * @brief Calculates the checksum for a given Pelco-D message.
@@ -68,6 +69,7 @@ pelco_d_error_t pelco_d_create_message(pelco_d_message_t *msg,
     msg->data1 = data1;
     msg->data2 = data2;
     msg->checksum = pelco_d_checksum(msg);
+    LOG_TRACE("Pelco-D message to %u: %02X %02X %02X %02X.", address, command1, command2, data1, data2);
 
     return PELCO_D_SUCCESS;
 }
@@ -77,6 +79,7 @@ pelco_d_error_t pelco_d_validate_message(const pelco_d_message_t *msg) {
         return PELCO_D_ERROR_NULL_POINTER;
     }
     if (msg->sync != PELCO_D_SYNC_BYTE) {
+        LOG_TRACE("Pelco-D message rejected: sync byte %02X.", msg->sync);
         return PELCO_D_ERROR_CHECKSUM;
     }
     if (msg->address > PELCO_D_MAX_ADDRESS) {
@@ -84,6 +87,8 @@ pelco_d_error_t pelco_d_validate_message(const pelco_d_message_t *msg) {
     }
     uint8_t checksum = pelco_d_checksum(msg);
     if (checksum != msg->checksum) {
+        LOG_TRACE("Pelco-D message from %u rejected: checksum %02X, expected %02X.",
+            msg->address, msg->checksum, checksum);
         return PELCO_D_ERROR_CHECKSUM;
     }
     return PELCO_D_SUCCESS;
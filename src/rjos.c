@@ -9,6 +9,12 @@ void rjos_init(const char *config_file, char *log_file) {
     if (config_load(config_file) != 0 || logger_init(log_file, LOG_LEVEL_DEBUG) != 0) {
         exit(EXIT_FAILURE);
     }
+
+    /* Keep the process resident when the configuration asks for it. */
+    const char *lock = config_get("mlockall");
+    if (lock && atoi(lock) != 0 && system_lock_memory() != 0) {
+        logger_log(LOG_LEVEL_WARN, "Failed to lock process memory.");
+    }
 }
 
 void rjos_cleanup(void) {
@@ -13,6 +13,7 @@
  * - System-level initialization handled by `system_init`.
  * - Loading the system configuration using the provided configuration file.
  * - Setting up the logging system with the specified log file and default debug log level.
+ * - Locking the process memory with `system_lock_memory` if the configuration sets `mlockall=1`.
  *
  * If any of the setup steps (configuration loading or logger initialization) fail,
  * the function will terminate the program with an error code.
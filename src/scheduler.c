@@ -1,14 +1,16 @@
 #include "logger.h"
 #include "scheduler.h"
 #include "system.h"
+#include "util/sched_phase.h"
 #include "util/sched_util.h"
 
 #include <signal.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
-
-static sched_t sched = { NULL, 0, 0, 0, NULL };
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
 
 /**
  * @brief Indicates if a shutdown has been requested.
@@ -29,105 +31,1358 @@ static void handle_signal(int sig) {
     shutdown_requested = 1;
 }
 
-int sched_init(size_t max_tasks) {
-    sched.tasks = calloc(max_tasks, sizeof(sched_task_t));
-    if (!sched.tasks) {
+int sched_init(sched_t *sched, size_t max_tasks) {
+    return sched_init_backend(sched, max_tasks, SCHED_BACKEND_HEAP);
+}
+
+int sched_init_backend(sched_t *sched, size_t max_tasks, sched_backend_t backend) {
+    if (!sched) {
+        return -1;
+    }
+    memset(sched, 0, sizeof(*sched));
+    sched->tasks    = sched_calloc_aligned(max_tasks, sizeof(sched_task_t));
+    sched->due_us   = sched_calloc_aligned(max_tasks, sizeof(uint64_t));
+    sched->order    = calloc(max_tasks ? max_tasks : 1, sizeof(size_t));
+    sched->retiring = calloc(max_tasks ? max_tasks : 1, sizeof(size_t));
+    sched->ready    = calloc(max_tasks ? max_tasks : 1, sizeof(sched_ready_t));
+    if (!sched->tasks || !sched->due_us || !sched->order || !sched->retiring || !sched->ready ||
+        sched_slots_init(&sched->slots, max_tasks) != 0) {
         logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for scheduler tasks.");
+        free(sched->tasks);
+        free(sched->due_us);
+        free(sched->order);
+        free(sched->retiring);
+        free(sched->ready);
+        sched->tasks = NULL;
+        return -1;
+    }
+    /* Generations start at 1 so that no handle equals SCHED_HANDLE_INVALID. */
+    for (size_t i = 0; i < max_tasks; i++) {
+        sched->tasks[i].gen = 1;
+        sched->due_us[i] = UINT64_MAX;
+    }
+    sched->due_min_us = UINT64_MAX;
+    int rc = 0;
+    switch (backend) {
+        case SCHED_BACKEND_HEAP:
+            rc = sched_heap_init(&sched->run_queue, max_tasks);
+            break;
+        case SCHED_BACKEND_WHEEL:
+            rc = sched_wheel_init(&sched->wheel, max_tasks, millis());
+            break;
+        case SCHED_BACKEND_LINEAR:
+            break;
+        default:
+            rc = -1;
+            break;
+    }
+    if (rc == 0 && sched_cmdq_init(&sched->submissions, SCHED_SUBMIT_QUEUE_SIZE) != 0) {
+        if (backend == SCHED_BACKEND_HEAP) {
+            sched_heap_destroy(&sched->run_queue);
+        } else if (backend == SCHED_BACKEND_WHEEL) {
+            sched_wheel_destroy(&sched->wheel);
+        }
+        rc = -1;
+    }
+    if (rc != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for scheduler run queue.");
+        sched_slots_destroy(&sched->slots);
+        free(sched->tasks);
+        free(sched->due_us);
+        free(sched->order);
+        free(sched->retiring);
+        free(sched->ready);
+        sched->tasks = NULL;
         return -1;
     }
-    sched.max_tasks = max_tasks;
-    sched.tasks_count = 0;
-    sched.running = 0;
+    sched->backend = backend;
+    sched->max_tasks = max_tasks;
+    sched->tasks_count = 0;
+    atomic_init(&sched->running, 0);
+    sched->log_hook = NULL;
+    sched->scan_pos = 0;
+    sched->histograms = 1;
+    sched->timing = SCHED_TIMING_RELATIVE;
+    sched->catchup = SCHED_CATCHUP_ALL;
+    sched->overrun_policy = SCHED_OVERRUN_SKIP;
+    sched->max_instances = 1;
+    sched->policy = SCHED_POLICY_STATIC;
+    sched->admissible = 1;
+    sched->cpu = -1;
     return 0;
 }
 
-int sched_add_task(task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name) {
-    if (!fn || sched.tasks_count >= sched.max_tasks) {
+/**
+ * @brief Sets the release time of a slot in the packed due-time array.
+ * @details The array mirrors the run queue for the scans of the linear
+ * backend and of scheduler_pt: eight releases per cache line instead of one
+ * task per line. UINT64_MAX marks a slot that is not queued.
+ */
+static void set_due(sched_t *sched, size_t idx, uint64_t due_us) {
+    uint64_t previous_us = sched->due_us[idx];
+    sched->due_count += (previous_us == UINT64_MAX) - (due_us == UINT64_MAX);
+    sched->due_us[idx] = due_us;
+    if (due_us < sched->due_min_us) {
+        sched->due_min_us = due_us;
+    }
+}
+
+/**
+ * @brief Inserts a task into the run queue keyed on its next release time.
+ *
+ * @param idx Index of the task in the scheduler task table.
+ */
+static void run_queue_push(sched_t *sched, size_t idx) {
+    const sched_task_t *task = &sched->tasks[idx];
+    set_due(sched, idx, task->release_us);
+
+    switch (sched->backend) {
+        case SCHED_BACKEND_HEAP: {
+            sched_heap_entry_t entry = {
+                .due_us   = task->release_us,
+                .priority = task->priority,
+                .idx      = idx,
+            };
+            (void)sched_heap_push(&sched->run_queue, entry);
+            break;
+        }
+        case SCHED_BACKEND_WHEEL:
+            /* Round up so the wheel never releases a task early. */
+            (void)sched_wheel_remove(&sched->wheel, idx);
+            (void)sched_wheel_insert(&sched->wheel, idx, (uint32_t)((task->release_us + 999) / 1000));
+            break;
+        case SCHED_BACKEND_LINEAR:
+        default:
+            /* The linear backend scans the task table directly. */
+            break;
+    }
+}
+
+/**
+ * @brief Removes a task from the run queue, if it is queued.
+ *
+ * @param idx Index of the task in the scheduler task table.
+ */
+static void run_queue_remove(sched_t *sched, size_t idx) {
+    set_due(sched, idx, UINT64_MAX);
+    switch (sched->backend) {
+        case SCHED_BACKEND_HEAP:
+            (void)sched_heap_remove(&sched->run_queue, idx);
+            break;
+        case SCHED_BACKEND_WHEEL:
+            (void)sched_wheel_remove(&sched->wheel, idx);
+            break;
+        case SCHED_BACKEND_LINEAR:
+        default:
+            /* Inactive tasks are skipped by the scan. */
+            break;
+    }
+}
+
+/**
+ * @brief Removes the next due task from the run queue.
+ *
+ * @param now_us Timestamp of the current scheduler wakeup.
+ * @param idx Receives the index of the due task.
+ * @return Returns 0 if a task is due, or -1 otherwise.
+ */
+static int run_queue_pop_due(sched_t *sched, uint64_t now_us, size_t *idx) {
+    switch (sched->backend) {
+        case SCHED_BACKEND_HEAP: {
+            const sched_heap_entry_t *top = sched_heap_peek(&sched->run_queue);
+            if (!top || top->due_us > now_us) {
+                return -1;
+            }
+            sched_heap_entry_t entry;
+            sched_heap_pop(&sched->run_queue, &entry);
+            *idx = entry.idx;
+            set_due(sched, entry.idx, UINT64_MAX);
+            return 0;
+        }
+        case SCHED_BACKEND_WHEEL:
+            if (sched_wheel_pop_due(&sched->wheel, (uint32_t)(now_us / 1000), idx) != 0) {
+                return -1;
+            }
+            set_due(sched, *idx, UINT64_MAX);
+            return 0;
+        case SCHED_BACKEND_LINEAR:
+        default:
+            /* Skip the scan when nothing can be due yet. */
+            if (sched->scan_pos == 0 && now_us < sched->due_min_us) {
+                return -1;
+            }
+            /* Resume the scan where the previous pop of this wakeup stopped. */
+            while (sched->scan_pos < sched->order_count) {
+                size_t slot = sched->order[sched->scan_pos++];
+                if (sched->due_us[slot] <= now_us) {
+                    set_due(sched, slot, UINT64_MAX);
+                    *idx = slot;
+                    return 0;
+                }
+            }
+            return -1;
+    }
+}
+
+/**
+ * @brief Computes the time until the next task in the run queue is due.
+ *
+ * @param now_us Timestamp of the current scheduler wakeup.
+ * @return Microseconds until the next due task, 0 if one is already due,
+ *         or UINT64_MAX if the run queue is empty.
+ */
+static uint64_t run_queue_next_due(sched_t *sched, uint64_t now_us) {
+    uint64_t due_us = UINT64_MAX;
+    switch (sched->backend) {
+        case SCHED_BACKEND_HEAP: {
+            const sched_heap_entry_t *top = sched_heap_peek(&sched->run_queue);
+            if (!top) {
+                return UINT64_MAX;
+            }
+            due_us = top->due_us;
+            break;
+        }
+        case SCHED_BACKEND_WHEEL: {
+            uint32_t due_ms;
+            if (sched_wheel_next_due(&sched->wheel, &due_ms) != 0) {
+                return UINT64_MAX;
+            }
+            int32_t ahead_ms = (int32_t)(due_ms - (uint32_t)(now_us / 1000));
+            if (ahead_ms <= 0) {
+                return 0;
+            }
+            return (uint64_t)ahead_ms * 1000 - now_us % 1000;
+        }
+        case SCHED_BACKEND_LINEAR:
+        default:
+            /* Slot order is as good as priority order for a minimum. */
+            for (size_t i = 0; i < sched->tasks_count; i++) {
+                if (sched->due_us[i] < due_us) {
+                    due_us = sched->due_us[i];
+                }
+            }
+            sched->due_min_us = due_us;
+            if (due_us == UINT64_MAX) {
+                return UINT64_MAX;
+            }
+            break;
+    }
+    return (due_us > now_us) ? due_us - now_us : 0;
+}
+
+/**
+ * @brief Returns the number of tasks currently waiting in the run queue.
+ */
+static size_t run_queue_depth(const sched_t *sched) {
+    switch (sched->backend) {
+        case SCHED_BACKEND_HEAP:
+            return sched->run_queue.count;
+        case SCHED_BACKEND_WHEEL:
+            return sched->wheel.count;
+        case SCHED_BACKEND_LINEAR:
+        default:
+            return sched->due_count;
+    }
+}
+
+/**
+ * @brief Rebuilds the run queue from the active tasks of the task table.
+ */
+static void run_queue_rebuild(sched_t *sched) {
+    if (sched->backend == SCHED_BACKEND_HEAP) {
+        sched_heap_clear(&sched->run_queue);
+    } else if (sched->backend == SCHED_BACKEND_WHEEL) {
+        sched_wheel_clear(&sched->wheel, sched->wheel.current);
+    }
+    for (size_t i = 0; i < sched->tasks_count; i++) {
+        if (sched->tasks[i].active) {
+            run_queue_push(sched, i);
+        } else {
+            set_due(sched, i, UINT64_MAX);
+        }
+    }
+    sched->stats.queue_depth = run_queue_depth(sched);
+}
+
+/**
+ * @brief Tells whether the loop walks the task table in priority order.
+ * @details Only the linear backend and the dispatcher of scheduler_pt do;
+ * the other backends order ties by priority in their run queue, so they skip
+ * the O(n) upkeep of the order.
+ */
+static int walks_order(const sched_t *sched) {
+    return sched->backend == SCHED_BACKEND_LINEAR || sched->pool != NULL;
+}
+
+/**
+ * @brief Inserts a slot into the priority order once it is kept sorted.
+ * @details Before that, the order is built in one pass by sort_tasks_by_priority().
+ */
+static void order_insert(sched_t *sched, size_t idx) {
+    if (!sched->order_sorted) {
+        return;
+    }
+    /* Binary search for the end of the run of equal priorities. */
+    uint8_t priority = sched->tasks[idx].priority;
+    size_t lo = 0;
+    size_t hi = sched->order_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (sched->tasks[sched->order[mid]].priority >= priority) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    memmove(&sched->order[lo + 1], &sched->order[lo], (sched->order_count - lo) * sizeof(size_t));
+    sched->order[lo] = idx;
+    sched->order_count++;
+    /* Keep the cursor of a linear scan on the same task. */
+    if (lo < sched->scan_pos) {
+        sched->scan_pos++;
+    }
+}
+
+/**
+ * @brief Removes a slot from the priority order once it is kept sorted.
+ */
+static void order_remove(sched_t *sched, size_t idx) {
+    if (!sched->order_sorted) {
+        return;
+    }
+    for (size_t pos = 0; pos < sched->order_count; pos++) {
+        if (sched->order[pos] == idx) {
+            memmove(&sched->order[pos], &sched->order[pos + 1], (sched->order_count - pos - 1) * sizeof(size_t));
+            sched->order_count--;
+            if (pos < sched->scan_pos) {
+                sched->scan_pos--;
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Builds the handle of the task occupying a slot.
+ */
+static sched_handle_t make_handle(size_t idx, uint32_t gen) {
+    return ((sched_handle_t)gen << 32) | (uint32_t)idx;
+}
+
+/**
+ * @brief Resets the histograms a reused slot kept from its previous task.
+ */
+static void reset_task_hist(sched_task_hist_t *hist) {
+    hist_reset(&hist->exec);
+    hist_reset(&hist->jitter);
+    hist_reset(&hist->lateness);
+}
+
+/**
+ * @brief Clears the budget a reused slot kept from its previous task.
+ */
+static void reset_task_budget(sched_task_t *task) {
+    atomic_store(&task->budget_us, 0);
+    atomic_store(&task->budget_action, SCHED_BUDGET_LOG);
+    for (size_t i = 0; i < SCHED_MAX_INSTANCES; i++) {
+        atomic_store(&task->run_start_us[i], 0);
+    }
+    atomic_store(&task->budget_trips, 0);
+    atomic_store(&task->degraded, 0);
+}
+
+/**
+ * @brief Clears the counters a reused slot kept from its previous task.
+ */
+static void reset_task_counters(sched_task_t *task) {
+    seqlock_write_begin(&task->seq);
+    task->deadline_ms = 0;
+    task->run_count = 0;
+    task->total_duration_us = 0;
+    task->max_duration_us = 0;
+    task->overrun_count = 0;
+    task->skip_count = 0;
+    task->wcet_us = 0;
+    seqlock_write_end(&task->seq);
+}
+
+/**
+ * @brief Fills a free slot of the task table and queues the task.
+ *
+ * @return The handle of the task, or SCHED_HANDLE_INVALID on failure.
+ */
+static sched_handle_t add_task(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name, int oneshot) {
+    size_t idx;
+    if (!sched || !fn || sched_slots_take(&sched->slots, &idx) != 0) {
         logger_log(LOG_LEVEL_ERROR, "Failed to add task to scheduler: %s.", name);
-        return -1;
+        return SCHED_HANDLE_INVALID;
+    }
+    if (idx >= sched->tasks_count) {
+        sched->tasks_count = idx + 1;
     }
-    sched_task_t *task = &sched.tasks[sched.tasks_count++];
+    sched_task_t *task = &sched->tasks[idx];
+    uint64_t now_us = micros64();
     task->callback = fn;
     task->data = data;
-    task->name = strdup(name);
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
     task->interval_ms = interval_ms;
-    task->last_run_ms = millis();
+    task->last_run_ms = (uint32_t)(now_us / 1000);
+    task->release_us = now_us + (uint64_t)interval_ms * 1000;
     task->priority = priority;
-    logger_log(LOG_LEVEL_DEBUG, "Added task to scheduler: %s.", task->name);
+    task->oneshot = (uint8_t)(oneshot != 0);
+    task->active = 1;
+    task->overrun_policy = (uint8_t)sched->overrun_policy;
+    task->max_instances = sched->max_instances;
+    reset_task_counters(task);
+    reset_task_budget(task);
+    if (sched->histograms && !oneshot) {
+        /* A reused slot keeps the histograms of its previous task. */
+        if (task->hist) {
+            reset_task_hist(task->hist);
+        } else {
+            task->hist = calloc(1, sizeof(sched_task_hist_t));
+        }
+    }
+    order_insert(sched, idx);
+    run_queue_push(sched, idx);
+    sched->stats.queue_depth++;
+    LOG_DEBUG("Added task to scheduler: %s.", task->name);
+    return make_handle(idx, task->gen);
+}
+
+int sched_add_task(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name) {
+    return add_task(sched, fn, data, interval_ms, priority, name, 0) != SCHED_HANDLE_INVALID ? 0 : -1;
+}
+
+int sched_add_timeout(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority, const char *name) {
+    return add_task(sched, fn, data, delay_ms, priority, name, 1) != SCHED_HANDLE_INVALID ? 0 : -1;
+}
+
+sched_handle_t sched_add_oneshot(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority,
+        const char *name) {
+    return add_task(sched, fn, data, delay_ms, priority, name, 1);
+}
+
+int sched_cancel_task(sched_t *sched, sched_handle_t handle) {
+    if (!sched || handle == SCHED_HANDLE_INVALID || sched_handle_index(handle) >= sched->max_tasks) {
+        return -1;
+    }
+    size_t idx = sched_handle_index(handle);
+    sched_task_t *task = &sched->tasks[idx];
+    if (task->gen != (uint32_t)(handle >> 32) || !(task->active || task->paused)) {
+        return -1;
+    }
+    sched_retire_task(sched, idx);
     return 0;
 }
 
-void sched_start(void) {
-    sched.running = 1;
-    sort_tasks_by_priority(&sched);
+/**
+ * @brief Queues a request for the loop, logging if the queue is full.
+ */
+static int submit(sched_t *sched, const sched_cmd_t *cmd) {
+    if (sched_cmdq_push(&sched->submissions, cmd) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Scheduler submission queue full.");
+        return -1;
+    }
+    /* Only pay for a wakeup when the loop may be blocked. */
+    atomic_fetch_add(&sched->wake_seq, 1);
+    if (atomic_load(&sched->sleeping)) {
+        if (sched->wakeup) {
+            sched->wakeup(sched);
+        } else {
+            wake_waiters(&sched->wake_seq);
+        }
+    }
+    return 0;
+}
 
-    while (!sched_should_exit()) {
-        uint32_t now_ms = millis();
-        uint32_t next_due_ms = UINT32_MAX;
+static int submit_handle(sched_t *sched, sched_cmd_type_t type, sched_handle_t handle, uint32_t interval_ms) {
+    if (!sched || handle == SCHED_HANDLE_INVALID || sched_handle_index(handle) >= sched->max_tasks) {
+        return -1;
+    }
+    sched_cmd_t cmd = {
+        .type        = type,
+        .idx         = sched_handle_index(handle),
+        .gen         = (uint32_t)(handle >> 32),
+        .interval_ms = interval_ms,
+    };
+    return submit(sched, &cmd);
+}
 
-        for (size_t i = 0; i < sched.tasks_count; i++) {
-            sched_task_t *task = &sched.tasks[i];
+/**
+ * @brief Takes a free slot and submits the task that will occupy it.
+ *
+ * @return The handle of the task, or SCHED_HANDLE_INVALID on failure.
+ */
+static sched_handle_t submit_add(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint32_t interval_ms,
+        uint8_t priority, const char *name, int oneshot) {
+    if (!sched || !fn) {
+        return SCHED_HANDLE_INVALID;
+    }
+    /* Take the slot without touching the live table, which belongs to the loop. */
+    size_t idx;
+    if (sched_slots_take(&sched->slots, &idx) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to add task to scheduler: %s.", name);
+        return SCHED_HANDLE_INVALID;
+    }
+    /* A free slot is not touched by the loop, so its generation and histograms are ours to read. */
+    const sched_task_t *task = &sched->tasks[idx];
+    sched_cmd_t cmd = {
+        .type        = SCHED_CMD_ADD,
+        .idx         = idx,
+        .gen         = task->gen,
+        .interval_ms = interval_ms,
+        .delay_ms    = delay_ms,
+        .priority    = priority,
+        .oneshot     = (uint8_t)(oneshot != 0),
+        .fn          = fn,
+        .data        = data,
+    };
+    snprintf(cmd.name, sizeof(cmd.name), "%s", name ? name : "");
+    if (sched->histograms && !oneshot && !task->hist) {
+        cmd.hist = calloc(1, sizeof(sched_task_hist_t));
+    }
+    if (submit(sched, &cmd) != 0) {
+        free(cmd.hist);
+        sched_slots_put(&sched->slots, idx);
+        return SCHED_HANDLE_INVALID;
+    }
+    return make_handle(idx, cmd.gen);
+}
 
-            uint32_t elapsed_ms = now_ms - task->last_run_ms;
-            if (elapsed_ms >= task->interval_ms) {
-                task->deadline_ms = task->last_run_ms + task->interval_ms;
+sched_handle_t sched_submit_add(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name) {
+    return submit_add(sched, fn, data, interval_ms, interval_ms, priority, name, 0);
+}
 
-                uint32_t start = millis();
-                task->callback(task->data);
-                uint32_t duration = millis() - start;
-                task->last_run_ms = now_ms;
+sched_handle_t sched_submit_deferred(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint32_t interval_ms,
+        uint8_t priority, const char *name) {
+    return submit_add(sched, fn, data, delay_ms, interval_ms, priority, name, 0);
+}
 
-                task->run_count++;
-                task->total_duration_ms += duration;
-                if (duration > task->max_duration_ms) {
-                    task->max_duration_ms = duration;
-                }
+sched_handle_t sched_submit_oneshot(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority,
+        const char *name) {
+    return submit_add(sched, fn, data, delay_ms, 0, priority, name, 1);
+}
 
-                /* Overrun detection. */
-                if (millis() > task->deadline_ms) {
-                    task->overrun_count++;
-                    logger_log(LOG_LEVEL_INFO, "Task %s exceeded deadline by %ums.",
-                        task->name, millis() - task->deadline_ms);
-                }
+int sched_submit_cancel(sched_t *sched, sched_handle_t handle) {
+    return submit_handle(sched, SCHED_CMD_CANCEL, handle, 0);
+}
+
+int sched_submit_pause(sched_t *sched, sched_handle_t handle) {
+    return submit_handle(sched, SCHED_CMD_PAUSE, handle, 0);
+}
+
+int sched_submit_resume(sched_t *sched, sched_handle_t handle) {
+    return submit_handle(sched, SCHED_CMD_RESUME, handle, 0);
+}
+
+int sched_submit_retime(sched_t *sched, sched_handle_t handle, uint32_t interval_ms) {
+    return submit_handle(sched, SCHED_CMD_RETIME, handle, interval_ms);
+}
+
+sched_handle_t sched_task_handle(const sched_t *sched, size_t idx) {
+    if (!sched || idx >= sched->max_tasks) {
+        return SCHED_HANDLE_INVALID;
+    }
+    return make_handle(idx, sched->tasks[idx].gen);
+}
+
+void sched_retire_task(sched_t *sched, size_t idx) {
+    sched_task_t *task = &sched->tasks[idx];
+    run_queue_remove(sched, idx);
+    order_remove(sched, idx);
+    task->active = 0;
+    task->paused = 0;
+    /* Invalidate the handles of the task before the slot can be reused. */
+    if (++task->gen == 0) {
+        task->gen = 1;
+    }
+    if (atomic_load(&task->instances) == 0 && atomic_load(&task->queued) == 0) {
+        sched_slots_put(&sched->slots, idx);
+    } else {
+        sched->retiring[sched->retiring_count++] = idx;
+    }
+}
 
-                /* Call the logging hook if set. */
-                if (sched.log_hook) {
-                    sched.log_hook(i, task->data);
+/**
+ * @brief Applies one submitted request to the task table and run queue.
+ */
+static void apply_submission(sched_t *sched, sched_cmd_t *cmd, uint64_t now_us) {
+    sched_task_t *task = &sched->tasks[cmd->idx];
+    if (cmd->gen != task->gen) {
+        /* The handle outlived its task, e.g. a timer cancelled after it fired. */
+        return;
+    }
+    switch (cmd->type) {
+        case SCHED_CMD_ADD:
+            task->callback = cmd->fn;
+            task->data = cmd->data;
+            memcpy(task->name, cmd->name, sizeof(task->name));
+            if (cmd->hist) {
+                task->hist = cmd->hist;
+            } else if (task->hist && !cmd->oneshot) {
+                reset_task_hist(task->hist);
+            }
+            task->interval_ms = cmd->interval_ms;
+            task->last_run_ms = (uint32_t)(now_us / 1000);
+            task->release_us = now_us + (uint64_t)cmd->delay_ms * 1000;
+            task->priority = cmd->priority;
+            task->oneshot = cmd->oneshot;
+            task->overrun_policy = (uint8_t)sched->overrun_policy;
+            task->max_instances = sched->max_instances;
+            reset_task_counters(task);
+            reset_task_budget(task);
+            task->active = 1;
+            if (cmd->idx >= sched->tasks_count) {
+                sched->tasks_count = cmd->idx + 1;
+            }
+            order_insert(sched, cmd->idx);
+            run_queue_push(sched, cmd->idx);
+            LOG_DEBUG("Added task to scheduler: %s.", task->name);
+            break;
+        case SCHED_CMD_CANCEL:
+            if (task->active || task->paused) {
+                sched_retire_task(sched, cmd->idx);
+            }
+            break;
+        case SCHED_CMD_PAUSE:
+            if (task->active) {
+                run_queue_remove(sched, cmd->idx);
+                task->active = 0;
+                task->paused = 1;
+            }
+            break;
+        case SCHED_CMD_RESUME:
+            if (task->paused) {
+                task->paused = 0;
+                task->active = 1;
+                task->release_us = now_us + (uint64_t)task->interval_ms * 1000;
+                run_queue_push(sched, cmd->idx);
+            }
+            break;
+        case SCHED_CMD_RETIME: {
+            /* Keep the previous release as the phase reference. */
+            uint64_t previous_us = task->release_us - (uint64_t)task->interval_ms * 1000;
+            uint64_t release_us = previous_us + (uint64_t)cmd->interval_ms * 1000;
+            seqlock_write_begin(&task->seq);
+            task->interval_ms = cmd->interval_ms;
+            task->release_us = release_us > now_us ? release_us : now_us;
+            seqlock_write_end(&task->seq);
+            if (task->active) {
+                run_queue_push(sched, cmd->idx);
+            }
+            break;
+        }
+    }
+}
+
+void sched_drain_submissions(sched_t *sched, uint64_t now_us) {
+    sched->drained_seq = atomic_load(&sched->wake_seq);
+    sched_cmd_t cmd;
+    while (sched_cmdq_pop(&sched->submissions, &cmd) == 0) {
+        apply_submission(sched, &cmd, now_us);
+    }
+
+    /* Free the retired slots whose last run on a worker has completed. */
+    for (size_t i = 0; i < sched->retiring_count;) {
+        const sched_task_t *task = &sched->tasks[sched->retiring[i]];
+        if (atomic_load(&task->instances) == 0 && atomic_load(&task->queued) == 0) {
+            sched_slots_put(&sched->slots, sched->retiring[i]);
+            sched->retiring[i] = sched->retiring[--sched->retiring_count];
+        } else {
+            i++;
+        }
+    }
+
+    /* Re-check schedulability against the latest measurements once per second. */
+    if (now_us >= sched->admission_us) {
+        sched->admission_us = now_us + 1000000;
+        sched_admission_t report;
+        int rc = sched_check_admission(sched, &report);
+        if (rc == 1 && sched->admissible) {
+            logger_log(LOG_LEVEL_WARN, "Task set not schedulable: utilization %.3f exceeds bound %.3f for %zu tasks.",
+                report.utilization, report.bound, report.tasks);
+        } else if (rc == 0 && !sched->admissible) {
+            logger_log(LOG_LEVEL_INFO, "Task set schedulable again: utilization %.3f.", report.utilization);
+        }
+        if (rc >= 0) {
+            sched->admissible = rc == 0;
+        }
+    }
+}
+
+/**
+ * @brief Moves the release time of a periodic task to its next period.
+ * @details In relative mode the next release is one interval after the
+ * wakeup that ran the task; with the wheel backend it is one interval after
+ * the tick of that wakeup, so the release stays on a millisecond boundary
+ * and rounding it up onto the wheel does not stretch the period. In absolute
+ * mode the release advances by exactly
+ * one interval from the previous release, so periods never drift; releases
+ * that were missed entirely are either run back-to-back or skipped,
+ * according to the catch-up policy.
+ *
+ * @param task The task that has just run.
+ * @param now_us Timestamp of the wakeup that ran the task.
+ * @param end_us Timestamp at which the task finished.
+ */
+static void advance_release(const sched_t *sched, sched_task_t *task, uint64_t now_us, uint64_t end_us) {
+    uint64_t period_us = (uint64_t)task->interval_ms * 1000;
+    if (sched->timing == SCHED_TIMING_RELATIVE) {
+        if (sched->backend == SCHED_BACKEND_WHEEL) {
+            now_us -= now_us % 1000;
+        }
+        task->release_us = now_us + period_us;
+        return;
+    }
+    task->release_us += period_us;
+    if (sched->catchup == SCHED_CATCHUP_SKIP && period_us > 0 && task->release_us <= end_us) {
+        uint64_t missed = (end_us - task->release_us) / period_us + 1;
+        task->release_us += missed * period_us;
+        task->skip_count += (uint32_t)missed;
+    }
+}
+
+/**
+ * @brief Executes a single due task and updates its statistics.
+ *
+ * @param idx Index of the task in the scheduler task table.
+ * @param now_us Timestamp of the current scheduler wakeup.
+ */
+static void run_task(sched_t *sched, size_t idx, uint64_t now_us) {
+    sched_task_t *task = &sched->tasks[idx];
+
+    /* A periodic task must complete before its next release; one-shots have no deadline. */
+    uint64_t deadline_us = task->release_us + (uint64_t)task->interval_ms * 1000;
+    if (!task->oneshot) {
+        task->deadline_ms = (uint32_t)(deadline_us / 1000);
+    }
+
+    /*
+     * Mark the run in flight like an instance of scheduler_pt, so a callback
+     * that cancels its own task leaves the slot on the retiring list until
+     * the run is accounted instead of handing it to a task it adds.
+     */
+    atomic_store_explicit(&task->instances, 1, memory_order_relaxed);
+    uint64_t start_us = micros64();
+    sched_budget_begin(task, 0, start_us);
+    task->callback(task->data);
+    uint64_t end_us = micros64();
+    uint64_t duration_us = end_us - start_us;
+    sched_budget_end(sched, idx, 0, duration_us);
+
+    seqlock_write_begin(&task->seq);
+    task->last_run_ms = (uint32_t)(now_us / 1000);
+    task->run_count++;
+    task->total_duration_us += duration_us;
+    if (duration_us > task->max_duration_us) {
+        task->max_duration_us = (uint32_t)duration_us;
+    }
+    if (task->hist && !task->oneshot) {
+        hist_record(&task->hist->exec, duration_us);
+        hist_record(&task->hist->jitter, start_us > task->release_us ? start_us - task->release_us : 0);
+        hist_record(&task->hist->lateness, end_us > deadline_us ? end_us - deadline_us : 0);
+    }
+
+    /* Overrun detection. */
+    int overrun = !task->oneshot && end_us > deadline_us;
+    if (overrun) {
+        task->overrun_count++;
+    }
+    if (!task->oneshot) {
+        advance_release(sched, task, now_us, end_us);
+    }
+    seqlock_write_end(&task->seq);
+
+    if (overrun) {
+        LOG_RATELIMITED(LOG_LEVEL_INFO, LOGGER_RATE, LOGGER_BURST,
+            "Task %s exceeded deadline by %ums.", task->name, (uint32_t)((end_us - deadline_us) / 1000));
+    }
+    LOG_TRACE("Task %s released at %lluus ran for %lluus.", task->name,
+        (unsigned long long)(deadline_us - (uint64_t)task->interval_ms * 1000), (unsigned long long)duration_us);
+
+    /* Call the logging hook if set. */
+    if (sched->log_hook) {
+        sched->log_hook(idx, task->data);
+    }
+    atomic_store_explicit(&task->instances, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief Queues a task that has just run for its next release, or retires it.
+ */
+static void requeue_task(sched_t *sched, size_t idx) {
+    if (!sched->tasks[idx].active) {
+        /* Cancelled or paused by its own callback. */
+        return;
+    }
+    if (sched->tasks[idx].oneshot) {
+        sched_retire_task(sched, idx);
+    } else {
+        run_queue_push(sched, idx);
+    }
+}
+
+/**
+ * @brief Orders released tasks by key, then by slot for a stable order.
+ */
+static int ready_cmp(const void *a, const void *b) {
+    const sched_ready_t *ra = a;
+    const sched_ready_t *rb = b;
+    if (ra->key != rb->key) {
+        return ra->key < rb->key ? -1 : 1;
+    }
+    return (ra->idx > rb->idx) - (ra->idx < rb->idx);
+}
+
+void sched_order_ready(const sched_t *sched, sched_ready_t *ready, size_t count) {
+    if (sched->policy == SCHED_POLICY_STATIC || count < 2) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const sched_task_t *task = &sched->tasks[ready[i].idx];
+        if (sched->policy == SCHED_POLICY_RM) {
+            /* Shortest interval first, the static priority breaking ties. */
+            ready[i].key = ((uint64_t)task->interval_ms << 8) | (uint8_t)~task->priority;
+        } else {
+            /* The deadline of a release is the next release, as in run_task(). */
+            ready[i].key = task->release_us + (uint64_t)task->interval_ms * 1000;
+        }
+    }
+    qsort(ready, count, sizeof(sched_ready_t), ready_cmp);
+}
+
+/**
+ * @brief Computes the Liu-Layland bound n(2^(1/n) - 1) without libm.
+ */
+static double rm_bound(size_t n) {
+    /* 2^(1/n) - 1 = e^x - 1 with x = ln(2)/n <= 0.7, so the series converges quickly. */
+    double x = 0.69314718055994530942 / (double)n;
+    double term = x;
+    double sum = 0.0;
+    for (int k = 2; k < 20; k++) {
+        sum += term;
+        term *= x / k;
+    }
+    return (double)n * sum;
+}
+
+int sched_check_admission(sched_t *sched, sched_admission_t *report) {
+    if (!sched) {
+        return -1;
+    }
+    sched_admission_t result = { 0 };
+    for (size_t i = 0; i < sched->tasks_count; i++) {
+        const sched_task_t *task = &sched->tasks[i];
+        if (!task->active || task->oneshot || task->interval_ms == 0) {
+            continue;
+        }
+        sched_task_counters_t counters;
+        sched_get_task_counters(sched, i, &counters);
+        result.utilization += (double)counters.max_duration_us / ((double)task->interval_ms * 1000.0);
+        result.tasks++;
+    }
+    if (sched->policy == SCHED_POLICY_EDF) {
+        result.bound = 1.0;
+    } else {
+        result.bound = result.tasks ? rm_bound(result.tasks) : 1.0;
+    }
+    result.schedulable = result.utilization <= result.bound;
+    if (report) {
+        *report = result;
+    }
+    return result.schedulable ? 0 : 1;
+}
+
+uint64_t sched_tick(sched_t *sched, uint64_t now_us) {
+    /*
+     * Pop due tasks in deadline order. The batch is bounded by the queue
+     * depth at wakeup so that a zero-interval task cannot starve the loop.
+     */
+    sched_drain_submissions(sched, now_us);
+    if (!sched->order_sorted && walks_order(sched)) {
+        sort_tasks_by_priority(sched);
+    }
+
+    size_t batch = 0;
+    size_t depth = run_queue_depth(sched);
+    size_t idx;
+    sched->scan_pos = 0;
+    if (sched->policy == SCHED_POLICY_STATIC) {
+        while (batch < depth && run_queue_pop_due(sched, now_us, &idx) == 0) {
+            run_task(sched, idx, now_us);
+            requeue_task(sched, idx);
+            batch++;
+        }
+    } else {
+        /* Collect the whole release before running any of it, so that the policy can order it. */
+        while (batch < depth && run_queue_pop_due(sched, now_us, &idx) == 0) {
+            sched->ready[batch].idx = idx;
+            sched->ready[batch++].gen = sched->tasks[idx].gen;
+        }
+        sched_order_ready(sched, sched->ready, batch);
+        for (size_t i = 0; i < batch; i++) {
+            idx = sched->ready[i].idx;
+            const sched_task_t *task = &sched->tasks[idx];
+            if (!task->active || task->gen != sched->ready[i].gen) {
+                /* Cancelled by a callback earlier in the batch, the slot may have been reused. */
+                continue;
+            }
+            run_task(sched, idx, now_us);
+            requeue_task(sched, idx);
+        }
+    }
+
+    sched->stats.wakeups++;
+    sched->stats.queue_depth = run_queue_depth(sched);
+    if (batch > sched->stats.max_batch) {
+        sched->stats.max_batch = batch;
+    }
+    return run_queue_next_due(sched, now_us);
+}
+
+/**
+ * @brief Hints the CPU that the caller is spinning.
+ */
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+void sched_sleep_until(sched_t *sched, uint64_t deadline_us) {
+    atomic_store(&sched->sleeping, 1);
+    unsigned seq = sched->drained_seq;
+    switch (sched->wait) {
+        case SCHED_WAIT_HYBRID:
+            if (deadline_us > sched->spin_us) {
+                wait_until_micros(deadline_us - sched->spin_us, &sched->wake_seq, seq);
+            }
+            /* Fall through to spin for the remainder. */
+        case SCHED_WAIT_SPIN:
+            while (micros64() < deadline_us && atomic_load_explicit(&sched->running, memory_order_relaxed) &&
+                   atomic_load_explicit(&sched->wake_seq, memory_order_relaxed) == seq) {
+                cpu_relax();
+            }
+            break;
+        default:
+            wait_until_micros(deadline_us, &sched->wake_seq, seq);
+            break;
+    }
+    atomic_store(&sched->sleeping, 0);
+    if (atomic_load(&sched->wake_seq) == seq) {
+        /* Only wakeups for a release measure the wait strategy. */
+        uint64_t now_us = micros64();
+        hist_record(&sched->wakeup_error, now_us > deadline_us ? now_us - deadline_us : 0);
+    }
+}
+
+void sched_apply_timer_slack(const sched_t *sched) {
+#if defined(__linux__) && defined(PR_SET_TIMERSLACK)
+    if (sched->timer_slack_ns && prctl(PR_SET_TIMERSLACK, (unsigned long)sched->timer_slack_ns, 0, 0, 0) != 0) {
+        logger_log(LOG_LEVEL_WARN, "Failed to set timer slack.");
+    }
+#else
+    (void)sched;
+#endif
+}
+
+void sched_prepare(sched_t *sched) {
+    /* Apply early submissions so that their slots are ordered with the rest. */
+    sched_drain_submissions(sched, micros64());
+    if (walks_order(sched)) {
+        sort_tasks_by_priority(sched);
+    }
+
+    /* Anchor every periodic task to a common release grid. */
+    if (sched->timing == SCHED_TIMING_ABSOLUTE) {
+        uint64_t anchor_us = micros64();
+        if (sched->backend == SCHED_BACKEND_WHEEL) {
+            /* Keep releases on the millisecond ticks of the wheel. */
+            anchor_us = (anchor_us + 999) / 1000 * 1000;
+        }
+        for (size_t i = 0; i < sched->tasks_count; i++) {
+            sched_task_t *task = &sched->tasks[i];
+            if (task->active && !task->oneshot) {
+                task->release_us = anchor_us + (uint64_t)task->interval_ms * 1000;
+            }
+        }
+    }
+
+    if (sched->stagger) {
+        sched_stagger(sched);
+    }
+
+    /* Rebuild the run queue once the release times are final. */
+    run_queue_rebuild(sched);
+}
+
+/**
+ * @brief Prepares the run queue and runs the scheduler loop until stopped.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+static void run_loop(sched_t *sched) {
+    sched_apply_timer_slack(sched);
+    sched_prepare(sched);
+
+    while (atomic_load(&sched->running) && !sched_should_exit()) {
+        uint64_t now_us  = micros64();
+        uint64_t next_us = sched_tick(sched, now_us);
+
+        /* Sleep until the next release, or poll again after 100 us when idle. */
+        if (next_us == UINT64_MAX) {
+            next_us = 100;
+        }
+        if (next_us > 0) {
+            sched_sleep_until(sched, now_us + next_us);
+        }
+    }
+}
+
+void sched_start(sched_t *sched) {
+    if (!sched) {
+        return;
+    }
+    atomic_store(&sched->running, 1);
+    run_loop(sched);
+}
+
+static void *sched_thread(void *arg) {
+    run_loop((sched_t *)arg);
+    return NULL;
+}
+
+int sched_start_thread(sched_t *sched, int cpu) {
+    if (!sched) {
+        return -1;
+    }
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    if (cpu >= 0 && sched_attr_pin_cpu(&attr, cpu) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to pin scheduler thread to CPU %d.", cpu);
+        pthread_attr_destroy(&attr);
+        return -1;
+    }
+
+    /* Mark the scheduler running first so an early sched_stop() is not lost. */
+    atomic_store(&sched->running, 1);
+    sched->cpu = cpu;
+    int rc = pthread_create(&sched->thread, &attr, sched_thread, sched);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to create scheduler thread.");
+        atomic_store(&sched->running, 0);
+        sched->cpu = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int sched_join(sched_t *sched) {
+    if (!sched) {
+        return -1;
+    }
+    return pthread_join(sched->thread, NULL) == 0 ? 0 : -1;
+}
+
+void sched_stop(sched_t *sched) {
+    if (sched) {
+        atomic_store(&sched->running, 0);
+    }
+}
+
+void sched_destroy(sched_t *sched) {
+    if (!sched) {
+        return;
+    }
+    sched_watchdog_stop(sched);
+    sched_cmd_t cmd;
+    while (sched_cmdq_pop(&sched->submissions, &cmd) == 0) {
+        if (cmd.type == SCHED_CMD_ADD) {
+            free(cmd.hist);
+        }
+    }
+    sched_cmdq_destroy(&sched->submissions);
+    for (size_t i = 0; i < sched->tasks_count; ++i) {
+        free(sched->tasks[i].hist);
+    }
+    free(sched->tasks);
+    free(sched->due_us);
+    free(sched->order);
+    free(sched->retiring);
+    free(sched->ready);
+    sched_slots_destroy(&sched->slots);
+    sched->due_us = NULL;
+    sched->order = NULL;
+    sched->retiring = NULL;
+    sched->ready = NULL;
+    sched->order_count = 0;
+    sched->order_sorted = 0;
+    sched->retiring_count = 0;
+    if (sched->backend == SCHED_BACKEND_HEAP) {
+        sched_heap_destroy(&sched->run_queue);
+    } else if (sched->backend == SCHED_BACKEND_WHEEL) {
+        sched_wheel_destroy(&sched->wheel);
+    }
+    sched->tasks = NULL;
+    sched->max_tasks   = 0;
+    sched->tasks_count = 0;
+}
+
+void sched_set_timing(sched_t *sched, sched_timing_t timing, sched_catchup_t catchup) {
+    sched->timing  = timing;
+    sched->catchup = catchup;
+}
+
+void sched_set_stagger(sched_t *sched, int enabled) {
+    sched->stagger = enabled;
+}
+
+int sched_set_wcet(sched_t *sched, size_t idx, uint32_t wcet_us) {
+    if (!sched || idx >= sched->max_tasks) {
+        return -1;
+    }
+    sched->tasks[idx].wcet_us = wcet_us;
+    return 0;
+}
+
+int sched_stagger(sched_t *sched) {
+    /* Place the most important tasks first: priority, then the shorter interval. */
+    size_t count = 0;
+    for (size_t i = 0; i < sched->tasks_count; i++) {
+        const sched_task_t *task = &sched->tasks[i];
+        if (task->active && !task->oneshot && task->interval_ms) {
+            sched->ready[count].key = ((uint64_t)(uint8_t)~task->priority << 32) | task->interval_ms;
+            sched->ready[count].idx = i;
+            count++;
+        }
+    }
+    qsort(sched->ready, count, sizeof(sched_ready_t), ready_cmp);
+
+    sched_phase_task_t *phases = malloc((count ? count : 1) * sizeof(sched_phase_task_t));
+    uint32_t *offsets = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!phases || !offsets) {
+        free(phases);
+        free(offsets);
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for task phases.");
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        const sched_task_t *task = &sched->tasks[sched->ready[i].idx];
+        phases[i].interval_ms = task->interval_ms;
+        phases[i].wcet_us = task->wcet_us > task->max_duration_us ? task->wcet_us : task->max_duration_us;
+    }
+    int rc = sched_phase_assign(phases, count, offsets);
+    if (rc != 0) {
+        logger_log(LOG_LEVEL_WARN, "Hyperperiod of the task set too long, releases not staggered.");
+    } else {
+        /* Offset 0 keeps the usual first release, one interval after start. */
+        uint64_t anchor_us = (micros64() + 999) / 1000 * 1000;
+        for (size_t i = 0; i < count; i++) {
+            sched_task_t *task = &sched->tasks[sched->ready[i].idx];
+            uint32_t first_ms = offsets[i] ? offsets[i] : task->interval_ms;
+            task->release_us = anchor_us + (uint64_t)first_ms * 1000;
+            set_due(sched, sched->ready[i].idx, task->release_us);
+        }
+        logger_log(LOG_LEVEL_INFO, "Staggered the releases of %zu periodic tasks.", count);
+    }
+    free(phases);
+    free(offsets);
+    return rc;
+}
+
+int sched_set_budget(sched_t *sched, size_t idx, uint32_t budget_us, sched_budget_action_t action) {
+    if (!sched || idx >= sched->max_tasks) {
+        return -1;
+    }
+    atomic_store(&sched->tasks[idx].budget_action, (uint8_t)action);
+    atomic_store(&sched->tasks[idx].budget_us, budget_us);
+    return 0;
+}
+
+/**
+ * @brief Counts a run that exceeded its budget and takes the action of the task.
+ *
+ * @param idx Index of the task.
+ * @param name Name of the task, or NULL off the thread that ran it, where the
+ *        name may be rewritten concurrently.
+ * @param budget_us The budget that was exceeded.
+ * @param elapsed_us Time the run has taken so far.
+ */
+static void budget_trip(sched_t *sched, size_t idx, const char *name, uint32_t budget_us, uint64_t elapsed_us) {
+    sched_task_t *task = &sched->tasks[idx];
+    atomic_fetch_add(&task->budget_trips, 1);
+    atomic_fetch_add(&sched->budget_trips, 1);
+    if (name) {
+        LOG_RATELIMITED(LOG_LEVEL_WARN, LOGGER_RATE, LOGGER_BURST,
+            "Task %s exceeded its budget of %uus, running for %lluus.", name, budget_us, (unsigned long long)elapsed_us);
+    } else {
+        LOG_RATELIMITED(LOG_LEVEL_WARN, LOGGER_RATE, LOGGER_BURST,
+            "Task %zu exceeded its budget of %uus, still running after %lluus.", idx, budget_us,
+            (unsigned long long)elapsed_us);
+    }
+
+    switch ((sched_budget_action_t)atomic_load(&task->budget_action)) {
+        case SCHED_BUDGET_DEGRADE:
+            atomic_store(&task->degraded, 1);
+            break;
+        case SCHED_BUDGET_SKIP:
+            /* The loop owns the run queue, so the pause goes through the submission queue. */
+            sched_submit_pause(sched, sched_task_handle(sched, idx));
+            break;
+        case SCHED_BUDGET_ABORT:
+            logger_log(LOG_LEVEL_ERROR, "Aborting on budget overrun of task %zu.", idx);
+            abort();
+        case SCHED_BUDGET_LOG:
+        default:
+            break;
+    }
+}
+
+void sched_budget_end(sched_t *sched, size_t idx, unsigned instance, uint64_t duration_us) {
+    sched_task_t *task = &sched->tasks[idx];
+    uint32_t budget_us = atomic_load_explicit(&task->budget_us, memory_order_relaxed);
+    if (!budget_us) {
+        return;
+    }
+    /* The watchdog flags the runs it has already tripped. */
+    uint64_t start_us = atomic_exchange(&task->run_start_us[instance], 0);
+    if (!(start_us & SCHED_BUDGET_TRIPPED) && duration_us > budget_us) {
+        budget_trip(sched, idx, task->name, budget_us, duration_us);
+    }
+}
+
+static void *watchdog_thread(void *arg) {
+    sched_t *sched = arg;
+    while (atomic_load(&sched->watchdog_running)) {
+        uint64_t now_us = micros64();
+        size_t count = atomic_load(&sched->tasks_count);
+        for (size_t i = 0; i < count; i++) {
+            sched_task_t *task = &sched->tasks[i];
+            uint32_t budget_us = atomic_load_explicit(&task->budget_us, memory_order_relaxed);
+            if (!budget_us) {
+                continue;
+            }
+            for (size_t j = 0; j < SCHED_MAX_INSTANCES; j++) {
+                _Atomic uint64_t *run_start = &task->run_start_us[j];
+                uint64_t start_us = atomic_load_explicit(run_start, memory_order_acquire);
+                if (start_us == 0 || (start_us & SCHED_BUDGET_TRIPPED) || now_us <= start_us + budget_us) {
+                    continue;
                 }
-            } else {
-                uint32_t diff_ms = task->interval_ms - elapsed_ms;
-                if (diff_ms < next_due_ms) {
-                    next_due_ms = diff_ms;
+                /* Losing the race means the run just returned and sched_budget_end() handles it. */
+                if (atomic_compare_exchange_strong(run_start, &start_us, start_us | SCHED_BUDGET_TRIPPED)) {
+                    budget_trip(sched, i, NULL, budget_us, now_us - start_us);
                 }
             }
         }
-        /* Sleep until the next task is due, or default to 100 us. */
-        uint32_t usleep_mul;
-        if (next_due_ms == UINT32_MAX) {
-            usleep_mul = 1;
-        } else {
-            usleep_mul = next_due_ms;
+        sleep_until_micros(now_us + sched->watchdog_period_us);
+    }
+    return NULL;
+}
+
+int sched_watchdog_start(sched_t *sched, uint32_t period_us) {
+    if (!sched || period_us == 0 || atomic_load(&sched->watchdog_running)) {
+        return -1;
+    }
+    sched->watchdog_period_us = period_us;
+    atomic_store(&sched->watchdog_running, 1);
+    if (pthread_create(&sched->watchdog, NULL, watchdog_thread, sched) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to create scheduler watchdog thread.");
+        atomic_store(&sched->watchdog_running, 0);
+        return -1;
+    }
+    return 0;
+}
+
+void sched_watchdog_stop(sched_t *sched) {
+    if (sched && atomic_exchange(&sched->watchdog_running, 0)) {
+        pthread_join(sched->watchdog, NULL);
+    }
+}
+
+void sched_set_policy(sched_t *sched, sched_policy_t policy) {
+    sched->policy = policy;
+}
+
+void sched_set_wait(sched_t *sched, sched_wait_t wait, uint32_t spin_us, uint64_t timer_slack_ns) {
+    sched->wait = wait;
+    sched->spin_us = spin_us;
+    sched->timer_slack_ns = timer_slack_ns;
+    sched->stats.wait = wait;
+}
+
+void sched_set_histograms(sched_t *sched, int enabled) {
+    sched->histograms = enabled;
+}
+
+/**
+ * @brief Summarizes a histogram into the percentiles reported by the stats API.
+ */
+static void summarize(const hist_t *hist, sched_latency_t *out) {
+    out->count   = hist->total;
+    out->p50_us  = hist_percentile(hist, 50.0);
+    out->p99_us  = hist_percentile(hist, 99.0);
+    out->p999_us = hist_percentile(hist, 99.9);
+    out->max_us  = hist->max;
+}
+
+int sched_get_task_stats(const sched_t *sched, size_t idx, sched_task_stats_t *stats) {
+    if (!sched || !stats || idx >= sched->tasks_count || !sched->tasks[idx].hist) {
+        return -1;
+    }
+    const sched_task_hist_t *hist = sched->tasks[idx].hist;
+    summarize(&hist->exec, &stats->exec);
+    summarize(&hist->jitter, &stats->jitter);
+    summarize(&hist->lateness, &stats->lateness);
+    return 0;
+}
+
+void sched_reset_task_stats(sched_t *sched) {
+    for (size_t i = 0; i < sched->tasks_count; i++) {
+        if (sched->tasks[i].hist) {
+            hist_reset(&sched->tasks[i].hist->exec);
+            hist_reset(&sched->tasks[i].hist->jitter);
+            hist_reset(&sched->tasks[i].hist->lateness);
         }
-        usleep(usleep_mul * 100);
     }
 }
 
-void sched_stop(void) {
-    sched.running = 0;
+int sched_get_task_counters(sched_t *sched, size_t idx, sched_task_counters_t *counters) {
+    if (!sched || !counters || idx >= sched->tasks_count) {
+        return -1;
+    }
+    sched_task_t *task = &sched->tasks[idx];
+    unsigned seq;
+    do {
+        seq = seqlock_read_begin(&task->seq);
+        counters->last_run_ms       = task->last_run_ms;
+        counters->release_us        = task->release_us;
+        counters->run_count         = task->run_count;
+        counters->total_duration_us = task->total_duration_us;
+        counters->max_duration_us   = task->max_duration_us;
+        counters->overrun_count     = task->overrun_count;
+        counters->skip_count        = task->skip_count;
+    } while (seqlock_read_retry(&task->seq, seq));
+    counters->budget_trips = atomic_load(&task->budget_trips);
+    counters->degraded     = atomic_load(&task->degraded);
+    return 0;
 }
 
-void sched_destroy(void) {
-    for (size_t i = 0; i < sched.tasks_count; ++i) {
-        free(sched.tasks[i].name);
+void sched_get_stats(const sched_t *sched, sched_stats_t *stats) {
+    if (sched && stats) {
+        *stats = sched->stats;
+        summarize(&sched->wakeup_error, &stats->wakeup_error);
+        stats->budget_trips = atomic_load(&sched->budget_trips);
     }
-    free(sched.tasks);
-    sched.tasks = NULL;
-    sched.max_tasks   = 0;
-    sched.tasks_count = 0;
 }
 
-void sched_set_log_hook(sched_log_fn log_hook) {
-    sched.log_hook = log_hook;
+void sched_set_log_hook(sched_t *sched, sched_log_fn log_hook) {
+    if (sched) {
+        sched->log_hook = log_hook;
+    }
 }
 
 int sched_should_exit(void) {
@@ -1,51 +1,317 @@
 #ifndef RJOS_SCHEDULER_H
 #define RJOS_SCHEDULER_H
 
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#include "util/hist.h"
+#include "util/sched_cmdq.h"
+#include "util/sched_heap.h"
+#include "util/sched_slots.h"
+#include "util/sched_wheel.h"
+#include "util/seqlock.h"
+
+/** Capacity of the queue of requests submitted to a running scheduler. */
+#define SCHED_SUBMIT_QUEUE_SIZE 256
+
+/** Capacity of a task name, including the terminating NUL. Longer names are truncated. */
+#define SCHED_TASK_NAME_LEN SCHED_CMD_NAME_LEN
+
 typedef void (*task_fn)(void *data);
 typedef void (*sched_log_fn)(size_t idx, void *data);
 
+/**
+ * Handle of a task, pairing its slot in the task table with the generation
+ * of the slot. A slot is reused once its task is cancelled or, for a one-shot
+ * task, has run; the generation then changes so that requests made through a
+ * stale handle are ignored instead of hitting the new occupant.
+ */
+typedef uint64_t sched_handle_t;
+
+/** Handle returned when a task could not be added. Never refers to a task. */
+#define SCHED_HANDLE_INVALID ((sched_handle_t)0)
+
+/**
+ * Returns the slot of a task handle, as passed to the log hook and to
+ * sched_get_task_counters().
+ */
+static inline size_t sched_handle_index(sched_handle_t handle) {
+    return (size_t)(handle & 0xffffffffu);
+}
+
+/**
+ * Enumeration of the run queue implementations available to the scheduler.
+ */
+typedef enum sched_backend {
+    SCHED_BACKEND_HEAP   = 0,   /**< Binary min-heap, O(log n) per dispatch */
+    SCHED_BACKEND_LINEAR = 1,   /**< Full table scan per wakeup, O(n) */
+    SCHED_BACKEND_WHEEL  = 2,   /**< Hierarchical timing wheel, O(1) per dispatch */
+} sched_backend_t;
+
+/**
+ * Enumeration of the ways the next release of a periodic task is computed.
+ */
+typedef enum sched_timing {
+    SCHED_TIMING_RELATIVE = 0,  /**< Next release is one interval after the task last ran */
+    SCHED_TIMING_ABSOLUTE = 1,  /**< Releases advance by exactly one interval from an anchor */
+} sched_timing_t;
+
+/**
+ * Enumeration of the policies for releases missed in absolute timing mode.
+ */
+typedef enum sched_catchup {
+    SCHED_CATCHUP_ALL  = 0,     /**< Run every missed release back-to-back */
+    SCHED_CATCHUP_SKIP = 1,     /**< Drop missed releases and resume on the next one */
+} sched_catchup_t;
+
+/**
+ * Enumeration of the policies for a release that arrives while the previous
+ * run of the task is still executing, in the overlapping mode of scheduler_pt.
+ */
+typedef enum sched_overrun {
+    SCHED_OVERRUN_SKIP       = 0,   /**< Drop the release */
+    SCHED_OVERRUN_QUEUE      = 1,   /**< Run once more right after the current run, drop further releases */
+    SCHED_OVERRUN_CONCURRENT = 2,   /**< Start another instance, up to a per-task limit */
+} sched_overrun_t;
+
+/**
+ * Enumeration of the ways the scheduler loop waits for the next release.
+ */
+typedef enum sched_wait {
+    SCHED_WAIT_SLEEP  = 0,  /**< Sleep until the release */
+    SCHED_WAIT_HYBRID = 1,  /**< Sleep until shortly before the release, then spin */
+    SCHED_WAIT_SPIN   = 2,  /**< Busy-poll the clock, for isolated cores */
+} sched_wait_t;
+
+/**
+ * Enumeration of the orders in which tasks released in the same wakeup run.
+ */
+typedef enum sched_policy {
+    SCHED_POLICY_STATIC = 0,    /**< Release time, then the static priority of the task */
+    SCHED_POLICY_RM     = 1,    /**< Rate-monotonic: shortest interval first */
+    SCHED_POLICY_EDF    = 2,    /**< Earliest deadline first, the deadline being the next release */
+} sched_policy_t;
+
+/**
+ * Enumeration of the actions taken when a task exceeds its execution budget.
+ */
+typedef enum sched_budget_action {
+    SCHED_BUDGET_LOG     = 0,   /**< Log a warning */
+    SCHED_BUDGET_DEGRADE = 1,   /**< Log and mark the task degraded */
+    SCHED_BUDGET_SKIP    = 2,   /**< Log and pause the task once the run returns */
+    SCHED_BUDGET_ABORT   = 3,   /**< Log and abort the process, e.g. to be restarted by a supervisor */
+} sched_budget_action_t;
+
+/** Upper bound of the instances of a task running at the same time, see scheduler_pt. */
+#define SCHED_MAX_INSTANCES 8
+
+/** Flag set in the start time of a run once its budget trip has been handled. */
+#define SCHED_BUDGET_TRIPPED (UINT64_C(1) << 63)
+
+/**
+ * Struct holding the latency histograms of a task, in microseconds.
+ */
+typedef struct sched_task_hist {
+    hist_t exec;            /**< Callback execution time */
+    hist_t jitter;          /**< Actual start minus scheduled release */
+    hist_t lateness;        /**< Completion minus deadline, 0 when on time */
+} sched_task_hist_t;
+
 /**
  * Struct representing a scheduled task in the system.
+ *
+ * Each task starts on its own cache line, so that workers of scheduler_pt
+ * updating the counters of neighbouring tasks do not share lines. The fields
+ * touched by every run come first; the name and the rarely read settings
+ * follow. The release-time scan of the loop reads the packed due_us array of
+ * the scheduler instead of this table.
  */
 typedef struct sched_task {
-    char    *name;
-    task_fn  callback;      /**< Function to execute */
+    _Alignas(64) task_fn callback;  /**< Function to execute */
     void    *data;          /**< Arguments of the function to execute */
+    uint64_t release_us;    /**< Next scheduled release, as returned by micros64() */
     uint32_t interval_ms;   /**< Execution interval in milliseconds */
     uint32_t last_run_ms;   /**< Timestamp of last execution */
-    uint8_t  priority;      /**< 0 = Lowest, 255 = Highest */
-    uint32_t run_count;
-    uint32_t total_duration_ms;
-    uint32_t max_duration_ms;
     uint32_t deadline_ms;
+    uint32_t run_count;
+    uint64_t total_duration_us;
+    uint32_t max_duration_us;
     uint32_t overrun_count;
+    uint32_t skip_count;    /**< Releases dropped by SCHED_CATCHUP_SKIP or the overrun policy */
+    _Atomic uint32_t gen;   /**< Generation of the slot, bumped each time the slot is freed */
+    uint8_t  priority;      /**< 0 = Lowest, 255 = Highest */
+    uint8_t  oneshot;       /**< Non-zero if the task runs once and is then retired */
+    uint8_t  active;        /**< Non-zero while the task is waiting to run */
+    uint8_t  paused;        /**< Non-zero while the task is paused by sched_submit_pause() */
+    uint8_t  overrun_policy;    /**< sched_overrun_t, used by the overlapping mode of scheduler_pt */
+    uint8_t  max_instances;     /**< Instance limit of SCHED_OVERRUN_CONCURRENT */
+    _Atomic uint8_t budget_action;  /**< sched_budget_action_t taken when the budget is exceeded */
+    seqlock_t seq;          /**< Guards the counters against torn reads from other threads */
+    sched_task_hist_t *hist;    /**< Latency histograms, NULL if disabled */
+    _Atomic uint64_t run_start_us[SCHED_MAX_INSTANCES];  /**< Start of the run of each instance, 0 if idle, for the watchdog */
+    _Atomic uint32_t budget_us;     /**< Execution budget, 0 if unbounded */
+    atomic_uint instances;      /**< Bitmask of the instances currently running */
+    atomic_uint queued;         /**< Non-zero if SCHED_OVERRUN_QUEUE holds a pending run */
+    atomic_uint budget_trips;   /**< Runs that exceeded the budget */
+    atomic_uint degraded;       /**< Non-zero once SCHED_BUDGET_DEGRADE has tripped */
+    uint32_t wcet_us;       /**< Declared worst-case execution time, 0 if unknown */
+    char     name[SCHED_TASK_NAME_LEN];
 } sched_task_t;
 
+/**
+ * Struct representing a consistent copy of the counters of a single task.
+ */
+typedef struct sched_task_counters {
+    uint32_t last_run_ms;
+    uint64_t release_us;
+    uint32_t run_count;
+    uint64_t total_duration_us;
+    uint32_t max_duration_us;
+    uint32_t overrun_count;
+    uint32_t skip_count;
+    uint32_t budget_trips;
+    uint32_t degraded;
+} sched_task_counters_t;
+
+/**
+ * Struct representing a percentile summary of one latency histogram.
+ */
+typedef struct sched_latency {
+    uint64_t count;
+    uint64_t p50_us;
+    uint64_t p99_us;
+    uint64_t p999_us;
+    uint64_t max_us;
+} sched_latency_t;
+
+/**
+ * Struct representing runtime statistics of the scheduler.
+ */
+typedef struct sched_stats {
+    size_t   queue_depth;   /**< Number of tasks waiting in the run queue */
+    size_t   max_batch;     /**< Largest number of tasks released in a single wakeup */
+    uint32_t wakeups;       /**< Number of scheduler loop iterations */
+    sched_wait_t    wait;           /**< Active wait strategy */
+    sched_latency_t wakeup_error;   /**< Actual wakeup minus intended wakeup */
+    uint32_t budget_trips;  /**< Runs of any task that exceeded their execution budget */
+} sched_stats_t;
+
+/**
+ * Struct representing the result of an admission-control check.
+ */
+typedef struct sched_admission {
+    double utilization;     /**< Sum over periodic tasks of worst measured execution time over interval */
+    double bound;           /**< Utilization the policy guarantees to schedule */
+    size_t tasks;           /**< Number of periodic tasks included */
+    int    schedulable;     /**< Non-zero if utilization does not exceed the bound */
+} sched_admission_t;
+
+/**
+ * Struct representing a task released in the current wakeup, with the key
+ * the scheduling policy orders it by.
+ */
+typedef struct sched_ready {
+    uint64_t key;
+    size_t   idx;
+    uint32_t gen;           /**< Generation of the slot when the task was released */
+} sched_ready_t;
+
+/**
+ * Struct representing the latency statistics of a single task.
+ */
+typedef struct sched_task_stats {
+    sched_latency_t exec;       /**< Callback execution time */
+    sched_latency_t jitter;     /**< Actual start minus scheduled release */
+    sched_latency_t lateness;   /**< Completion minus deadline, 0 when on time */
+} sched_task_stats_t;
+
+struct sched_pool;
+struct sched_ev;
+struct sched_co;
+
 /**
  * Struct representing a scheduler for managing and executing tasks.
  */
 typedef struct sched {
     sched_task_t *tasks;
     size_t        max_tasks;
-    size_t        tasks_count;
-    int           running;
+    atomic_size_t tasks_count;  /**< Slots in use so far, read by the watchdog */
+    sched_slots_t slots;        /**< Free task slots, taken from any thread */
+    size_t       *order;        /**< Task slots by priority, walked by the linear backend and scheduler_pt */
+    uint64_t     *due_us;       /**< Release time of each queued slot, UINT64_MAX otherwise, scanned for due tasks */
+    size_t        due_count;    /**< Number of queued slots in due_us */
+    uint64_t      due_min_us;   /**< Lower bound of the releases in due_us */
+    size_t        order_count;
+    int           order_sorted; /**< Non-zero once order is kept sorted incrementally */
+    size_t       *retiring;     /**< Freed slots whose last run, on the loop or a worker of scheduler_pt, is in flight */
+    size_t        retiring_count;
+    sched_ready_t *ready;       /**< Tasks released in the current wakeup */
+    sched_policy_t policy;      /**< Order of the tasks released in the same wakeup */
+    int           admissible;   /**< Result of the last periodic admission check */
+    uint64_t      admission_us; /**< Time of the next periodic admission check */
+    int           stagger;      /**< Non-zero to spread the first releases at start */
+    atomic_uint   budget_trips; /**< Runs of any task that exceeded their execution budget */
+    pthread_t     watchdog;     /**< Thread enforcing execution budgets, see sched_watchdog_start() */
+    atomic_int    watchdog_running;
+    uint32_t      watchdog_period_us;
+    sched_cmdq_t  submissions;  /**< Requests from other threads, drained by the loop */
+    atomic_uint   wake_seq;     /**< Bumped by every submission */
+    unsigned      drained_seq;  /**< Value of wake_seq when the loop last drained */
+    atomic_int    sleeping;     /**< Non-zero while the loop may be blocked in a wait */
+    void        (*wakeup)(struct sched *sched); /**< Wakes a loop blocked outside sched_sleep_until() */
+    atomic_int    running;
     sched_log_fn  log_hook;
+    sched_backend_t backend;
+    sched_timing_t  timing;
+    sched_catchup_t catchup;
+    sched_heap_t  run_queue;    /**< Tasks ordered by next due time, heap backend */
+    sched_wheel_t wheel;        /**< Tasks bucketed by due time, wheel backend */
+    size_t        scan_pos;     /**< Scan cursor of the linear backend */
+    int           histograms;   /**< Non-zero to record per-task latency histograms */
+    sched_stats_t stats;
+    sched_wait_t  wait;         /**< Wait strategy of the loop */
+    uint32_t      spin_us;      /**< Spin window before a release in hybrid mode */
+    uint64_t      timer_slack_ns;   /**< Timer slack of the loop thread, 0 to keep the default */
+    hist_t        wakeup_error; /**< Wakeup error of the loop, in microseconds */
+    pthread_t     thread;       /**< Thread running the loop, see sched_start_thread() */
+    int           cpu;          /**< CPU the loop thread is pinned to, -1 if unpinned */
+    struct sched_pool *pool;    /**< Worker pool of the threaded scheduler, see scheduler_pt.h */
+    struct sched_ev   *ev;      /**< Event loop state, see scheduler_ev.h */
+    struct sched_co   *co;      /**< Coroutine pool, see scheduler_co.h */
+    sched_overrun_t overrun_policy; /**< Overrun policy of tasks added from now on */
+    uint8_t       max_instances;    /**< Instance limit of tasks added from now on */
 } sched_t;
 
 /**
  * Initializes a scheduler instance with a specified maximum number of tasks.
  *
+ * @param sched A pointer to the scheduler instance to initialize.
+ * @param max_tasks The maximum number of tasks the scheduler can handle concurrently.
+ * @return Returns 0 on successful initialization. Returns -1 if an error occurs, such as memory allocation failure.
+ */
+int sched_init(sched_t *sched, size_t max_tasks);
+
+/**
+ * Initializes a scheduler instance with an explicit run queue backend.
+ *
+ * The heap backend suits up to a few thousand tasks. The timing wheel keeps
+ * insertion and expiry O(1) for tens of thousands of timers at a resolution
+ * of one millisecond, but does not order tasks that expire on the same tick
+ * by priority. The linear backend scans the whole table on every wakeup.
+ *
+ * @param sched A pointer to the scheduler instance to initialize.
  * @param max_tasks The maximum number of tasks the scheduler can handle concurrently.
+ * @param backend The run queue implementation to use.
  * @return Returns 0 on successful initialization. Returns -1 if an error occurs, such as memory allocation failure.
  */
-int sched_init(size_t max_tasks);
+int sched_init_backend(sched_t *sched, size_t max_tasks, sched_backend_t backend);
 
 /**
  * Adds a new task to the scheduler.
  *
+ * @param sched Pointer to the scheduler instance where the task will be added.
  * @param fn Function pointer representing the task to be executed.
  * @param data Pointer to the data that will be passed to the task's function.
  * @param interval_ms Execution interval for the task in milliseconds.
@@ -53,34 +319,519 @@ int sched_init(size_t max_tasks);
  * @param name Name of the task for identification purposes.
  * @return Returns 0 on success, or -1 on failure (e.g., if the scheduler is null, the function pointer is null, or the task limit is reached).
  */
-int sched_add_task(task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name);
+int sched_add_task(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name);
+
+/**
+ * Adds a one-shot task that runs once after the given delay.
+ *
+ * Timeouts may be armed from inside task callbacks, e.g. to schedule a
+ * protocol retry of the single-threaded loops. A fired timeout returns its
+ * slot to the free list. Use sched_submit_oneshot() from other threads or
+ * when the timer may have to be cancelled.
+ *
+ * @param sched Pointer to the scheduler instance where the task will be added.
+ * @param fn Function pointer representing the task to be executed.
+ * @param data Pointer to the data that will be passed to the task's function.
+ * @param delay_ms Delay before the task runs, in milliseconds.
+ * @param priority Priority of the task, where 0 represents the lowest and 255 represents the highest.
+ * @param name Name of the task for identification purposes.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_add_timeout(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority, const char *name);
+
+/**
+ * Adds a one-shot task like sched_add_timeout() and returns its handle.
+ *
+ * Unlike sched_submit_oneshot() the task is inserted immediately, without
+ * going through the bounded submission queue, so any number of timers can be
+ * armed in one tick. Only call it before the scheduler starts or from the
+ * thread running the loop.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fn The function to execute.
+ * @param data The user data passed to the function.
+ * @param delay_ms Delay before the task runs, in milliseconds.
+ * @param priority Tiebreak among tasks due at the same time.
+ * @param name The name of the task.
+ * @return The handle of the task, or SCHED_HANDLE_INVALID on failure.
+ */
+sched_handle_t sched_add_oneshot(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority,
+    const char *name);
+
+/**
+ * Cancels a task immediately and frees its slot. Only call it before the
+ * scheduler starts or from the thread running the loop; other threads use
+ * sched_submit_cancel().
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param handle Handle of the task.
+ * @return Returns 0 on success, or -1 if the handle is stale or invalid.
+ */
+int sched_cancel_task(sched_t *sched, sched_handle_t handle);
+
+/**
+ * Runs every task that is due at the given time.
+ *
+ * This is the body of the sched_start() loop. It can be called directly to
+ * drive the scheduler from an external loop or from a synthetic clock.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param now_us The current time in microseconds, as returned by micros64().
+ * @return Microseconds until the next task is due, 0 if a task is already due,
+ *         or UINT64_MAX if no task is queued.
+ */
+uint64_t sched_tick(sched_t *sched, uint64_t now_us);
+
+/**
+ * Adds a periodic task to a running scheduler from any thread.
+ *
+ * The task slot is taken from the free list immediately and the task is
+ * inserted by the loop when it drains its submission queue, at its next
+ * wakeup. The call never blocks the loop: requests travel through a lock-free
+ * queue and the task table is not re-sorted. The name is copied into the
+ * slot, so nothing is allocated unless latency histograms are enabled.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fn The function to execute.
+ * @param data The user data passed to the function.
+ * @param interval_ms The execution interval in milliseconds.
+ * @param priority Tiebreak among tasks due at the same time.
+ * @param name The name of the task.
+ * @return The handle of the new task, or SCHED_HANDLE_INVALID if the table
+ *         or the submission queue is full.
+ */
+sched_handle_t sched_submit_add(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name);
+
+/**
+ * Adds a periodic task whose first release is delayed, from any thread.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fn The function to execute.
+ * @param data The user data passed to the function.
+ * @param delay_ms Delay before the first release, in milliseconds.
+ * @param interval_ms The execution interval in milliseconds.
+ * @param priority Tiebreak among tasks due at the same time.
+ * @param name The name of the task.
+ * @return The handle of the new task, or SCHED_HANDLE_INVALID on failure.
+ */
+sched_handle_t sched_submit_deferred(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint32_t interval_ms,
+    uint8_t priority, const char *name);
+
+/**
+ * Arms a one-shot timer from any thread, e.g. "resend the query if no reply
+ * arrives within 50 ms".
+ *
+ * Arming and cancelling allocate nothing: the slot comes from a preallocated
+ * free list and returns to it once the task has run or been cancelled.
+ * One-shot tasks have no deadline, so they never count as overruns, and do
+ * not record latency histograms.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fn The function to execute.
+ * @param data The user data passed to the function.
+ * @param delay_ms Delay before the task runs, in milliseconds.
+ * @param priority Tiebreak among tasks due at the same time.
+ * @param name The name of the task.
+ * @return The handle of the timer, or SCHED_HANDLE_INVALID on failure.
+ */
+sched_handle_t sched_submit_oneshot(sched_t *sched, task_fn fn, void *data, uint32_t delay_ms, uint8_t priority,
+    const char *name);
+
+/**
+ * Cancels a task from any thread. The task does not run after the loop
+ * drains the request, and its slot is freed. Cancelling a one-shot task that
+ * has already run is a no-op.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param handle Handle of the task.
+ * @return Returns 0 if the request was queued, or -1 otherwise.
+ */
+int sched_submit_cancel(sched_t *sched, sched_handle_t handle);
+
+/**
+ * Pauses a task from any thread until sched_submit_resume() is called.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param handle Handle of the task.
+ * @return Returns 0 if the request was queued, or -1 otherwise.
+ */
+int sched_submit_pause(sched_t *sched, sched_handle_t handle);
+
+/**
+ * Resumes a paused task from any thread. The task is released one interval
+ * after the loop drains the request.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param handle Handle of the task.
+ * @return Returns 0 if the request was queued, or -1 otherwise.
+ */
+int sched_submit_resume(sched_t *sched, sched_handle_t handle);
+
+/**
+ * Changes the interval of a task from any thread. The next release is moved
+ * to one new interval after the previous release, or to now if that is
+ * already past.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param handle Handle of the task.
+ * @param interval_ms The new interval in milliseconds.
+ * @return Returns 0 if the request was queued, or -1 otherwise.
+ */
+int sched_submit_retime(sched_t *sched, sched_handle_t handle, uint32_t interval_ms);
+
+/**
+ * Returns the handle of the task currently occupying a slot, e.g. for a task
+ * added with sched_add_task() or the index passed to the log hook.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task.
+ * @return The handle, or SCHED_HANDLE_INVALID if the slot is out of range.
+ */
+sched_handle_t sched_task_handle(const sched_t *sched, size_t idx);
+
+/**
+ * Retires a task whose slot is no longer needed, returning the slot to the
+ * free list. Called by the scheduler loops after a one-shot task is released;
+ * the slot is held back until no worker of scheduler_pt still runs the task.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task.
+ */
+void sched_retire_task(sched_t *sched, size_t idx);
+
+/**
+ * Applies the requests queued by the sched_submit_* functions.
+ *
+ * Called by the scheduler loops between dispatches; custom loops driving
+ * sched_tick() get it for free. Also frees the slots of retired tasks and
+ * runs the periodic admission check.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param now_us Timestamp of the current wakeup.
+ */
+void sched_drain_submissions(sched_t *sched, uint64_t now_us);
+
+/**
+ * Blocks the loop until the given release or until a request is submitted.
+ *
+ * Uses the wait strategy selected with sched_set_wait(). A request submitted
+ * after the last sched_drain_submissions() ends the wait immediately, so that
+ * runtime changes take effect without waiting for the next release.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param deadline_us Release to wait for, as returned by micros64().
+ */
+void sched_sleep_until(sched_t *sched, uint64_t deadline_us);
+
+/**
+ * Applies the timer slack selected with sched_set_wait() to the calling thread.
+ *
+ * Timer slack is per thread, so every loop waiting with sched_sleep_until()
+ * calls this from its own thread before the first wait.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_apply_timer_slack(const sched_t *sched);
+
+/**
+ * Prepares the task table and run queue for a loop driving sched_tick().
+ *
+ * Orders the tasks by priority, anchors them to a common release grid in
+ * absolute timing mode, staggers them if enabled with sched_set_stagger()
+ * and rebuilds the run queue. sched_start() calls this
+ * itself; custom loops such as the event loop of scheduler_ev call it once
+ * before the first sched_tick().
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_prepare(sched_t *sched);
+
+/**
+ * Selects how release times of periodic tasks are computed.
+ *
+ * In absolute mode every periodic task is anchored to a common grid when
+ * sched_start() is called, and its release advances by exactly interval_ms
+ * per period regardless of how long the task ran. The loop sleeps until the
+ * next absolute release with clock_nanosleep(TIMER_ABSTIME), so periods do
+ * not drift. Must be called before sched_start().
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param timing The timing mode, SCHED_TIMING_RELATIVE by default.
+ * @param catchup The policy for missed releases in absolute mode.
+ */
+void sched_set_timing(sched_t *sched, sched_timing_t timing, sched_catchup_t catchup);
+
+/**
+ * Selects the order in which tasks released in the same wakeup run.
+ *
+ * With the static policy tasks run in release order and the priority given
+ * at registration breaks ties. Rate-monotonic derives the priority from the
+ * interval, shorter intervals first. EDF runs the task with the earliest
+ * deadline first; the deadline of a release is the next release, the same
+ * value stored in deadline_ms. Under the threaded scheduler the policy
+ * orders the dispatch of the tasks released in a tick.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param policy The scheduling policy, SCHED_POLICY_STATIC by default.
+ */
+void sched_set_policy(sched_t *sched, sched_policy_t policy);
+
+/**
+ * Orders the tasks released in a wakeup according to the scheduling policy.
+ *
+ * Fills in the key of each entry and sorts the entries. With the static
+ * policy the entries are left in the order given. Used by the scheduler loops.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param ready The released tasks.
+ * @param count Number of released tasks.
+ */
+void sched_order_ready(const sched_t *sched, sched_ready_t *ready, size_t count);
+
+/**
+ * Checks whether the current task set is schedulable on one core.
+ *
+ * The utilization of each periodic task is its worst measured execution time
+ * divided by its interval; tasks that have not run yet count as zero. The
+ * total is compared to the bound of the policy: 1 for EDF, and the
+ * Liu-Layland bound n(2^(1/n) - 1) for the rate-monotonic and static policies,
+ * which is sufficient but not necessary. The loops run this check once per
+ * second and log a warning when the task set stops being schedulable.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param report Receives the details of the check, may be NULL.
+ * @return Returns 0 if the task set is schedulable, 1 if it is not, or -1 on error.
+ */
+int sched_check_admission(sched_t *sched, sched_admission_t *report);
+
+/**
+ * Enables the phase staggering pass run when the scheduler starts.
+ *
+ * Tasks registered together share a phase, so e.g. every 1 Hz task fires in
+ * the same tick. When enabled, sched_start(), sched_pt_start() and
+ * sched_prepare() call sched_stagger() to spread the releases over the
+ * hyperperiod instead.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param enabled Non-zero to stagger the releases, zero to keep them in phase (default).
+ */
+void sched_set_stagger(sched_t *sched, int enabled);
+
+/**
+ * Declares the worst-case execution time of a task, used by the staggering
+ * pass to weigh the load of each release.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task, as passed to the log hook.
+ * @param wcet_us Worst-case execution time in microseconds.
+ * @return Returns 0 on success, or -1 if the index is out of range.
+ */
+int sched_set_wcet(sched_t *sched, size_t idx, uint32_t wcet_us);
+
+/**
+ * Spreads the releases of the periodic tasks across their hyperperiod.
+ *
+ * Assigns each task a release offset within its interval so that the peak
+ * per-tick load is minimized, weighing each release by the larger of the
+ * declared and the measured worst-case execution time; tasks that have
+ * neither count as one microsecond. Tasks are placed in priority order,
+ * so that high-priority tasks get the quietest ticks and low-priority tasks
+ * do not queue behind bursts. Works best with harmonic intervals, which keep
+ * the hyperperiod short; see sched_phase_assign(). Must be called before the
+ * loop starts.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @return Returns 0 on success, or -1 if the hyperperiod is too long, in
+ *         which case the releases are left unchanged.
+ */
+int sched_stagger(sched_t *sched);
+
+/**
+ * Gives a task an execution budget and the action taken when a run exceeds it.
+ *
+ * Overruns of the budget are detected when the run returns, and while the
+ * run is still executing by the watchdog started with sched_watchdog_start(),
+ * so that a callback that hangs is reported instead of stalling the loop
+ * silently. Each run trips at most once and is counted in the task counters
+ * and the scheduler stats. Must be called before the scheduler starts or from
+ * the loop thread.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task, as passed to the log hook.
+ * @param budget_us Execution budget in microseconds, 0 to remove it.
+ * @param action The action taken when a run exceeds the budget.
+ * @return Returns 0 on success, or -1 if the index is out of range.
+ */
+int sched_set_budget(sched_t *sched, size_t idx, uint32_t budget_us, sched_budget_action_t action);
+
+/**
+ * Starts the watchdog thread that checks the runs in progress against their
+ * execution budgets.
+ *
+ * The watchdog cannot interrupt a callback. With SCHED_BUDGET_SKIP the task
+ * is paused once it returns; a callback that never returns can only be dealt
+ * with by SCHED_BUDGET_ABORT.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param period_us Interval between two checks in microseconds.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_watchdog_start(sched_t *sched, uint32_t period_us);
+
+/**
+ * Stops the watchdog thread. Called by sched_destroy().
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_watchdog_stop(sched_t *sched);
+
+/**
+ * Marks the start of a run for budget enforcement. Used by the scheduler loops.
+ *
+ * @param task The task about to run.
+ * @param instance Number of the instance running, 0 on the loop thread.
+ * @param start_us Start of the run, as returned by micros64().
+ */
+static inline void sched_budget_begin(sched_task_t *task, unsigned instance, uint64_t start_us) {
+    if (atomic_load_explicit(&task->budget_us, memory_order_relaxed)) {
+        atomic_store_explicit(&task->run_start_us[instance], start_us, memory_order_release);
+    }
+}
+
+/**
+ * Marks the end of a run for budget enforcement, tripping the budget if the
+ * run exceeded it and the watchdog has not already done so. Used by the
+ * scheduler loops.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task that ran.
+ * @param instance Number of the instance that ran, as passed to sched_budget_begin().
+ * @param duration_us Duration of the run in microseconds.
+ */
+void sched_budget_end(sched_t *sched, size_t idx, unsigned instance, uint64_t duration_us);
+
+/**
+ * Selects how the scheduler loop waits for the next release.
+ *
+ * A plain sleep overshoots by the kernel wakeup latency plus the timer slack
+ * of the thread. In hybrid mode the loop sleeps until spin_us before the
+ * release and busy-polls the clock for the remainder, trading a little CPU
+ * for microsecond precision. Spin mode never sleeps and is meant for a loop
+ * pinned to an isolated core. Must be called before the scheduler starts.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param wait The wait strategy, SCHED_WAIT_SLEEP by default.
+ * @param spin_us Spin window of SCHED_WAIT_HYBRID in microseconds.
+ * @param timer_slack_ns Timer slack of the loop thread, or of the dispatcher
+ *                       of scheduler_pt (PR_SET_TIMERSLACK), or 0 to keep the
+ *                       default of 50 us.
+ */
+void sched_set_wait(sched_t *sched, sched_wait_t wait, uint32_t spin_us, uint64_t timer_slack_ns);
 
 /**
  * Starts the scheduler, managing tasks execution and priority.
  *
  * This function initializes the running loop for the scheduler to process
- * and execute tasks. Tasks are processed according to their priority and
- * interval timing. The function remains in a loop, continuously checking
- * for tasks to execute until an exit condition is triggered.
+ * and execute tasks. Tasks are kept in a run queue ordered by their next due
+ * time, with priority as a tiebreak, so each wakeup only touches the tasks
+ * that are actually due. The function remains in a loop until an exit
+ * condition is triggered.
+ *
+ * @param sched Pointer to the scheduler instance to start.
+ */
+void sched_start(sched_t *sched);
+
+/**
+ * Starts the scheduler loop on a dedicated thread.
+ *
+ * Every scheduler instance owns its task table, run queue and statistics, so
+ * several instances can run side by side, e.g. a fast control loop and slow
+ * housekeeping, each pinned to its own core.
+ *
+ * @param sched Pointer to the scheduler instance to start.
+ * @param cpu Index of the CPU to pin the thread to, or -1 to leave the affinity unchanged.
+ * @return Returns 0 on success, or -1 if the CPU is invalid or the thread could not be created.
+ */
+int sched_start_thread(sched_t *sched, int cpu);
+
+/**
+ * Waits for a scheduler started with sched_start_thread() to finish.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @return Returns 0 on success, or -1 on failure.
  */
-void sched_start(void);
+int sched_join(sched_t *sched);
 
 /**
  * Stops the scheduler by setting its running state to false.
+ *
+ * @param sched Pointer to the scheduler instance to be stopped.
  */
-void sched_stop(void);
+void sched_stop(sched_t *sched);
 
 /**
  * Destroys the scheduler and releases any allocated resources.
+ *
+ * @param sched Pointer to the scheduler instance to be destroyed.
+ */
+void sched_destroy(sched_t *sched);
+
+/**
+ * Retrieves a snapshot of the scheduler runtime statistics.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param stats Pointer to the structure that receives the statistics.
+ */
+void sched_get_stats(const sched_t *sched, sched_stats_t *stats);
+
+/**
+ * Enables or disables per-task latency histograms for subsequently added tasks.
+ *
+ * Histograms are enabled by default and cost about 2.3 KiB per task.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param enabled Non-zero to record histograms, zero to disable them.
+ */
+void sched_set_histograms(sched_t *sched, int enabled);
+
+/**
+ * Retrieves the latency percentiles of a task.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task, as passed to the log hook.
+ * @param stats Pointer to the structure that receives the statistics.
+ * @return Returns 0 on success, or -1 if the index is invalid or the task
+ *         has no histograms.
+ */
+int sched_get_task_stats(const sched_t *sched, size_t idx, sched_task_stats_t *stats);
+
+/**
+ * Clears the latency histograms of every task.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_reset_task_stats(sched_t *sched);
+
+/**
+ * Copies the counters of a task without stopping the thread that runs it.
+ *
+ * The copy is taken under the per-task sequence lock, so all fields belong to
+ * the same completed run even while the task executes on another core.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the task, as passed to the log hook.
+ * @param counters Pointer to the structure that receives the counters.
+ * @return Returns 0 on success, or -1 if the index is invalid.
  */
-void sched_destroy(void);
+int sched_get_task_counters(sched_t *sched, size_t idx, sched_task_counters_t *counters);
 
 /**
  * Sets a logging hook for the scheduler to allow tracking or debugging.
  *
+ * @param sched Pointer to the scheduler instance.
  * @param log_hook Function pointer to the log hook to be used for logging task-related events.
  */
-void sched_set_log_hook(sched_log_fn log_hook);
+void sched_set_log_hook(sched_t *sched, sched_log_fn log_hook);
 
 /**
  * Checks if the scheduler should exit.
@@ -109,7 +860,7 @@ void sched_setup_signal_handlers(void);
  */
 static inline uint32_t sched_avg_ms(sched_task_t *task) {
     if (task->run_count) {
-        return task->total_duration_ms / task->run_count;
+        return (uint32_t)(task->total_duration_us / task->run_count / 1000);
     }
     return 0;
 }
@@ -124,7 +875,7 @@ static inline uint32_t sched_avg_ms(sched_task_t *task) {
  */
 static inline uint32_t sched_avg_us(sched_task_t *task) {
     if (task->run_count) {
-        return 0;
+        return (uint32_t)(task->total_duration_us / task->run_count);
     }
     return 0;
 }
@@ -0,0 +1,343 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "scheduler_co.h"
+#include "scheduler_ev.h"
+#include "logger.h"
+
+#if defined(__linux__)
+
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#define CO_NONE         UINT32_MAX  /**< End of the free list */
+#define CO_MAX_EVENTS   64
+
+/**
+ * @brief Life cycle of a coroutine slot.
+ */
+typedef enum co_state {
+    CO_FREE,
+    CO_RUNNABLE,    /**< Spawned or resumed, not suspended */
+    CO_WAITING,     /**< Suspended in sched_yield_until() */
+    CO_DONE,        /**< The body returned, the slot is freed by the resumer */
+} co_state_t;
+
+/**
+ * @brief A coroutine and its preallocated stack.
+ */
+typedef struct sched_coro {
+    ucontext_t       ctx;
+    ucontext_t       caller;    /**< Context of the last resumer, also the uc_link of ctx */
+    char            *stack;
+    sched_co_fn      fn;
+    void            *data;
+    struct sched_co *pool;
+    sched_handle_t   timer;     /**< First run or timeout, SCHED_HANDLE_INVALID if none */
+    int              fd;        /**< Descriptor waited for, -1 if none */
+    int              result;    /**< Return value of the pending sched_yield_until() */
+    co_state_t       state;
+    uint8_t          priority;
+    uint32_t         next_free;
+    char             name[SCHED_TASK_NAME_LEN];
+} sched_coro_t;
+
+/**
+ * @brief Coroutine pool of a scheduler.
+ * @details Waiting descriptors are registered one-shot in a private epoll
+ * instance, whose own descriptor is watched by the event loop or polled by a
+ * periodic task, and carry the index of their coroutine.
+ */
+struct sched_co {
+    sched_t        *sched;
+    sched_coro_t   *coros;
+    size_t          capacity;
+    size_t          alive;
+    uint32_t        free_head;
+    char           *region;     /**< Stacks, each preceded by a guard page */
+    size_t          region_size;
+    size_t          stack_size;
+    int             epoll_fd;
+    sched_handle_t  poll_task;  /**< Periodic poll when there is no event loop */
+};
+
+/** Coroutine running on this thread, NULL outside coroutines. */
+static _Thread_local sched_coro_t *current;
+
+static void co_release(sched_coro_t *co) {
+    struct sched_co *pool = co->pool;
+    co->state = CO_FREE;
+    co->next_free = pool->free_head;
+    pool->free_head = (uint32_t)(co - pool->coros);
+    pool->alive--;
+}
+
+static void co_entry(void) {
+    sched_coro_t *co = current;
+    co->fn(co->data);
+    co->state = CO_DONE;
+    /* Returning switches to uc_link, the context of the resumer. */
+}
+
+/**
+ * @brief Runs a coroutine until it suspends or ends.
+ */
+static void co_resume(sched_coro_t *co) {
+    sched_coro_t *resumer = current;
+    current = co;
+    co->state = CO_RUNNABLE;
+    swapcontext(&co->caller, &co->ctx);
+    current = resumer;
+    if (co->state == CO_DONE) {
+        co_release(co);
+    }
+}
+
+/**
+ * @brief One-shot task starting a coroutine or ending its wait on a timeout.
+ */
+static void co_timer(void *data) {
+    sched_coro_t *co = data;
+    co->timer = SCHED_HANDLE_INVALID;
+    co->result = 0;
+    co_resume(co);
+}
+
+/**
+ * @brief Resumes the coroutines whose descriptor became readable.
+ */
+static void co_poll(struct sched_co *pool) {
+    struct epoll_event events[CO_MAX_EVENTS];
+    int count;
+    do {
+        count = epoll_wait(pool->epoll_fd, events, CO_MAX_EVENTS, 0);
+        for (int i = 0; i < count; i++) {
+            sched_coro_t *co = &pool->coros[events[i].data.u32];
+            if (co->state == CO_WAITING && co->fd >= 0) {
+                co->result = 1;
+                co_resume(co);
+            }
+        }
+    } while (count == CO_MAX_EVENTS);
+}
+
+static void co_poll_task(void *data) {
+    co_poll(data);
+}
+
+static void co_io(int fd, uint32_t events, void *data) {
+    (void)fd;
+    (void)events;
+    co_poll(data);
+}
+
+int sched_co_init(sched_t *sched, size_t max_coroutines, size_t stack_size) {
+    if (!sched || max_coroutines == 0 || max_coroutines >= CO_NONE || sched->co) {
+        return -1;
+    }
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    if (stack_size == 0) {
+        stack_size = SCHED_CO_STACK_SIZE;
+    }
+    stack_size = (stack_size + page - 1) / page * page;
+
+    struct sched_co *pool = calloc(1, sizeof(struct sched_co));
+    if (!pool) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for coroutines.");
+        return -1;
+    }
+    pool->sched = sched;
+    pool->capacity = max_coroutines;
+    pool->stack_size = stack_size;
+    pool->poll_task = SCHED_HANDLE_INVALID;
+    pool->region_size = max_coroutines * (page + stack_size);
+    pool->coros = calloc(max_coroutines, sizeof(sched_coro_t));
+    pool->region = mmap(NULL, pool->region_size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    pool->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!pool->coros || pool->region == MAP_FAILED || pool->epoll_fd < 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate coroutine stacks.");
+        if (pool->region != MAP_FAILED) {
+            munmap(pool->region, pool->region_size);
+        }
+        if (pool->epoll_fd >= 0) {
+            close(pool->epoll_fd);
+        }
+        free(pool->coros);
+        free(pool);
+        return -1;
+    }
+
+    /* Stacks grow down, so each guard page sits below its stack. */
+    for (size_t i = 0; i < max_coroutines; i++) {
+        char *block = pool->region + i * (page + stack_size);
+        if (mprotect(block, page, PROT_NONE) != 0) {
+            logger_log(LOG_LEVEL_WARN, "Failed to protect coroutine guard page.");
+        }
+        sched_coro_t *co = &pool->coros[i];
+        co->stack = block + page;
+        co->pool = pool;
+        co->fd = -1;
+        co->timer = SCHED_HANDLE_INVALID;
+        co->next_free = i + 1 < max_coroutines ? (uint32_t)(i + 1) : CO_NONE;
+    }
+    pool->free_head = 0;
+
+    int rc;
+    if (sched->ev) {
+        rc = sched_ev_add_io(sched, pool->epoll_fd, co_io, pool, "coroutines");
+    } else {
+        pool->poll_task = sched_submit_add(sched, co_poll_task, pool, 1, 255, "coroutines");
+        rc = pool->poll_task == SCHED_HANDLE_INVALID ? -1 : 0;
+    }
+    if (rc != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to watch coroutine descriptors.");
+        munmap(pool->region, pool->region_size);
+        close(pool->epoll_fd);
+        free(pool->coros);
+        free(pool);
+        return -1;
+    }
+    sched->co = pool;
+    return 0;
+}
+
+int sched_co_spawn(sched_t *sched, sched_co_fn fn, void *data, uint8_t priority, const char *name) {
+    struct sched_co *pool = sched ? sched->co : NULL;
+    if (!pool || !fn) {
+        return -1;
+    }
+    if (pool->free_head == CO_NONE) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to spawn coroutine %s: all coroutines in use.", name);
+        return -1;
+    }
+    sched_coro_t *co = &pool->coros[pool->free_head];
+
+    getcontext(&co->ctx);
+    co->ctx.uc_stack.ss_sp = co->stack;
+    co->ctx.uc_stack.ss_size = pool->stack_size;
+    co->ctx.uc_link = &co->caller;
+    makecontext(&co->ctx, co_entry, 0);
+    co->fn = fn;
+    co->data = data;
+    co->fd = -1;
+    co->priority = priority;
+    snprintf(co->name, sizeof(co->name), "%s", name ? name : "");
+
+    /* The first run is an ordinary one-shot task. */
+    co->timer = sched_add_oneshot(sched, co_timer, co, 0, priority, co->name);
+    if (co->timer == SCHED_HANDLE_INVALID) {
+        return -1;
+    }
+    co->state = CO_RUNNABLE;
+    pool->free_head = co->next_free;
+    pool->alive++;
+    return 0;
+}
+
+int sched_yield_until(int fd, uint32_t timeout_ms) {
+    sched_coro_t *co = current;
+    if (!co || (fd < 0 && timeout_ms == SCHED_CO_FOREVER)) {
+        return -1;
+    }
+    struct sched_co *pool = co->pool;
+
+    if (fd >= 0) {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = EPOLLIN | EPOLLONESHOT;
+        event.data.u32 = (uint32_t)(co - pool->coros);
+        if (epoll_ctl(pool->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Coroutine %s failed to watch descriptor %d.", co->name, fd);
+            return -1;
+        }
+        co->fd = fd;
+    }
+    if (timeout_ms != SCHED_CO_FOREVER) {
+        co->timer = sched_add_oneshot(pool->sched, co_timer, co, timeout_ms, co->priority, co->name);
+        if (co->timer == SCHED_HANDLE_INVALID) {
+            if (co->fd >= 0) {
+                epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, co->fd, NULL);
+                co->fd = -1;
+            }
+            return -1;
+        }
+    }
+
+    co->state = CO_WAITING;
+    swapcontext(&co->ctx, &co->caller);
+
+    /* Resumed by co_timer() or co_poll(); tear down whichever did not fire. */
+    if (co->fd >= 0) {
+        epoll_ctl(pool->epoll_fd, EPOLL_CTL_DEL, co->fd, NULL);
+        co->fd = -1;
+    }
+    if (co->timer != SCHED_HANDLE_INVALID) {
+        sched_cancel_task(pool->sched, co->timer);
+        co->timer = SCHED_HANDLE_INVALID;
+    }
+    return co->result;
+}
+
+size_t sched_co_count(const sched_t *sched) {
+    return sched && sched->co ? sched->co->alive : 0;
+}
+
+void sched_co_destroy(sched_t *sched) {
+    struct sched_co *pool = sched ? sched->co : NULL;
+    if (!pool) {
+        return;
+    }
+    for (size_t i = 0; i < pool->capacity; i++) {
+        if (pool->coros[i].timer != SCHED_HANDLE_INVALID) {
+            sched_cancel_task(sched, pool->coros[i].timer);
+        }
+    }
+    if (pool->poll_task != SCHED_HANDLE_INVALID) {
+        sched_cancel_task(sched, pool->poll_task);
+    }
+    munmap(pool->region, pool->region_size);
+    close(pool->epoll_fd);
+    free(pool->coros);
+    free(pool);
+    sched->co = NULL;
+}
+
+#else
+
+int sched_co_init(sched_t *sched, size_t max_coroutines, size_t stack_size) {
+    (void)sched;
+    (void)max_coroutines;
+    (void)stack_size;
+    logger_log(LOG_LEVEL_ERROR, "Coroutine tasks require ucontext and epoll.");
+    return -1;
+}
+
+int sched_co_spawn(sched_t *sched, sched_co_fn fn, void *data, uint8_t priority, const char *name) {
+    (void)sched;
+    (void)fn;
+    (void)data;
+    (void)priority;
+    (void)name;
+    return -1;
+}
+
+int sched_yield_until(int fd, uint32_t timeout_ms) {
+    (void)fd;
+    (void)timeout_ms;
+    return -1;
+}
+
+size_t sched_co_count(const sched_t *sched) {
+    (void)sched;
+    return 0;
+}
+
+void sched_co_destroy(sched_t *sched) {
+    (void)sched;
+}
+
+#endif
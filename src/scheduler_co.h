@@ -0,0 +1,94 @@
+#ifndef RJOS_SCHEDULER_CO_H
+#define RJOS_SCHEDULER_CO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "scheduler.h"
+
+/** Default stack size of a coroutine, excluding its guard page. */
+#define SCHED_CO_STACK_SIZE (64 * 1024)
+
+/** Timeout of sched_yield_until() that never expires. */
+#define SCHED_CO_FOREVER UINT32_MAX
+
+/**
+ * Body of a coroutine task. The coroutine ends when the function returns.
+ *
+ * @param data The user data passed to sched_co_spawn().
+ */
+typedef void (*sched_co_fn)(void *data);
+
+/**
+ * Attaches a pool of coroutines to a scheduler.
+ *
+ * Coroutine tasks run on the thread of the scheduler loop, like ordinary
+ * callbacks, but may suspend themselves with sched_yield_until() while they
+ * wait for a descriptor or a timeout, e.g. for the reply to a Pelco-D query,
+ * letting the loop run other tasks in the meantime. This gives thousands of
+ * concurrent protocol conversations on one thread without hand-written state
+ * machines.
+ *
+ * Every stack is allocated up front with a guard page below it, so a stack
+ * overflow faults instead of corrupting the neighbouring coroutine, and
+ * spawning a coroutine allocates nothing. The stacks are reserved without
+ * being committed, so only the pages a coroutine touches use memory.
+ *
+ * With the event loop of scheduler_ev, initialize it first: waiting
+ * descriptors are then watched by its epoll loop and resume their coroutine
+ * as soon as they are ready. With the other loops they are polled every
+ * millisecond. The coroutines are driven by sched_tick(), so the threaded
+ * scheduler of scheduler_pt is not supported. Only available on Linux.
+ *
+ * @param sched Pointer to the initialized scheduler instance.
+ * @param max_coroutines Maximum number of coroutines alive at the same time.
+ * @param stack_size Stack size of each coroutine, 0 for SCHED_CO_STACK_SIZE.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_co_init(sched_t *sched, size_t max_coroutines, size_t stack_size);
+
+/**
+ * Starts a coroutine task. It first runs at the next scheduler wakeup.
+ *
+ * Only call it before the scheduler starts or from the thread running the
+ * loop, including from another coroutine.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fn The body of the coroutine.
+ * @param data The user data passed to the body.
+ * @param priority Tiebreak among tasks due at the same time.
+ * @param name The name of the coroutine, used in log messages.
+ * @return Returns 0 on success, or -1 if every coroutine is in use.
+ */
+int sched_co_spawn(sched_t *sched, sched_co_fn fn, void *data, uint8_t priority, const char *name);
+
+/**
+ * Suspends the calling coroutine until a descriptor is readable or a timeout
+ * expires, and lets the scheduler run other tasks in the meantime.
+ *
+ * With a negative descriptor the coroutine simply sleeps; a timeout of 0
+ * then yields to the tasks already due.
+ *
+ * @param fd The descriptor to wait for, or -1 to wait for the timeout only.
+ * @param timeout_ms The timeout in milliseconds, or SCHED_CO_FOREVER.
+ * @return Returns 1 if the descriptor is readable, 0 if the timeout expired,
+ *         or -1 if not called from a coroutine or the wait cannot be set up.
+ */
+int sched_yield_until(int fd, uint32_t timeout_ms);
+
+/**
+ * Returns the number of coroutines currently alive.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+size_t sched_co_count(const sched_t *sched);
+
+/**
+ * Releases the coroutine pool. Coroutines that have not finished are
+ * discarded without being resumed. Call it before sched_destroy().
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_co_destroy(sched_t *sched);
+
+#endif
@@ -0,0 +1,250 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "scheduler_ev.h"
+#include "system.h"
+#include "logger.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#define EV_TIMER_ID     UINT32_MAX          /**< epoll tag of the release timer */
+#define EV_WAKE_ID      (UINT32_MAX - 1)    /**< epoll tag of the stop eventfd */
+#define EV_MAX_EVENTS   32
+
+/**
+ * @brief An I/O task bound to a descriptor.
+ */
+typedef struct sched_io {
+    int          fd;
+    sched_io_fn  callback;
+    void        *data;
+    char         name[SCHED_TASK_NAME_LEN];
+    uint32_t     run_count;
+} sched_io_t;
+
+/**
+ * @brief State of the event loop.
+ * @details A single timerfd is armed for the next release reported by
+ * sched_tick(), so periodic tasks keep using the run queue backends, and the
+ * eventfd lets sched_ev_stop() wake a loop blocked in epoll_wait().
+ */
+struct sched_ev {
+    int         epoll_fd;
+    int         timer_fd;
+    int         wake_fd;
+    sched_io_t *io;
+    size_t      io_count;
+    size_t      io_capacity;
+};
+
+static int ev_watch(struct sched_ev *ev, int fd, uint32_t id) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.u32 = id;
+    return epoll_ctl(ev->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static void ev_free(struct sched_ev *ev) {
+    if (ev->epoll_fd >= 0) {
+        close(ev->epoll_fd);
+    }
+    if (ev->timer_fd >= 0) {
+        close(ev->timer_fd);
+    }
+    if (ev->wake_fd >= 0) {
+        close(ev->wake_fd);
+    }
+    free(ev->io);
+    free(ev);
+}
+
+/**
+ * @brief Wakes the loop for a submitted request, see sched_t::wakeup.
+ */
+static void ev_wakeup(sched_t *sched) {
+    uint64_t one = 1;
+    (void)write(sched->ev->wake_fd, &one, sizeof(one));
+}
+
+int sched_ev_init(sched_t *sched, size_t max_tasks, size_t max_io) {
+    if (sched_init(sched, max_tasks) != 0) {
+        return -1;
+    }
+    struct sched_ev *ev = calloc(1, sizeof(struct sched_ev));
+    if (!ev) {
+        sched_destroy(sched);
+        return -1;
+    }
+    ev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    ev->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    ev->wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ev->io       = calloc(max_io ? max_io : 1, sizeof(sched_io_t));
+    ev->io_capacity = max_io;
+    if (ev->epoll_fd < 0 || ev->timer_fd < 0 || ev->wake_fd < 0 || !ev->io ||
+        ev_watch(ev, ev->timer_fd, EV_TIMER_ID) != 0 || ev_watch(ev, ev->wake_fd, EV_WAKE_ID) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to create scheduler event loop: %s.", strerror(errno));
+        ev_free(ev);
+        sched_destroy(sched);
+        return -1;
+    }
+    sched->ev = ev;
+    sched->wakeup = ev_wakeup;
+    return 0;
+}
+
+int sched_ev_add_io(sched_t *sched, int fd, sched_io_fn fn, void *data, const char *name) {
+    if (!sched || !sched->ev || !fn || fd < 0 || sched->ev->io_count >= sched->ev->io_capacity) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to add I/O task to scheduler: %s.", name);
+        return -1;
+    }
+    struct sched_ev *ev = sched->ev;
+    size_t idx = ev->io_count;
+    if (ev_watch(ev, fd, (uint32_t)idx) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to watch descriptor of %s: %s.", name, strerror(errno));
+        return -1;
+    }
+    sched_io_t *io = &ev->io[idx];
+    io->fd        = fd;
+    io->callback  = fn;
+    io->data      = data;
+    snprintf(io->name, sizeof(io->name), "%s", name ? name : "");
+    io->run_count = 0;
+    ev->io_count++;
+    LOG_DEBUG("Added I/O task to scheduler: %s.", name);
+    return 0;
+}
+
+/**
+ * @brief Arms the release timer for the given delay, or disarms it.
+ */
+static void ev_arm(struct sched_ev *ev, uint64_t next_us) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    if (next_us != UINT64_MAX) {
+        /* A zero expiry would disarm the timer, so fire after 1 ns instead. */
+        uint64_t next_ns = next_us ? next_us * 1000 : 1;
+        spec.it_value.tv_sec  = (time_t)(next_ns / UINT64_C(1000000000));
+        spec.it_value.tv_nsec = (long)(next_ns % UINT64_C(1000000000));
+    }
+    (void)timerfd_settime(ev->timer_fd, 0, &spec, NULL);
+}
+
+void sched_ev_start(sched_t *sched) {
+    if (!sched || !sched->ev) {
+        return;
+    }
+    struct sched_ev *ev = sched->ev;
+    struct epoll_event events[EV_MAX_EVENTS];
+    uint64_t expirations;
+
+    atomic_store(&sched->running, 1);
+    sched_prepare(sched);
+    ev_arm(ev, sched_tick(sched, micros64()));
+
+    while (atomic_load(&sched->running) && !sched_should_exit()) {
+        /* Do not block if a request arrived since the last drain. */
+        atomic_store(&sched->sleeping, 1);
+        int timeout = atomic_load(&sched->wake_seq) != sched->drained_seq ? 0 : -1;
+        int n = epoll_wait(ev->epoll_fd, events, EV_MAX_EVENTS, timeout);
+        atomic_store(&sched->sleeping, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger_log(LOG_LEVEL_ERROR, "epoll_wait failed: %s.", strerror(errno));
+            break;
+        }
+        int released = 0;
+        for (int i = 0; i < n; i++) {
+            uint32_t id = events[i].data.u32;
+            if (id == EV_TIMER_ID) {
+                (void)read(ev->timer_fd, &expirations, sizeof(expirations));
+                released = 1;
+            } else if (id == EV_WAKE_ID) {
+                (void)read(ev->wake_fd, &expirations, sizeof(expirations));
+                released = 1;
+            } else if (id < ev->io_count) {
+                sched_io_t *io = &ev->io[id];
+                io->callback(io->fd, events[i].events, io->data);
+                io->run_count++;
+            }
+        }
+        if (released || atomic_load(&sched->wake_seq) != sched->drained_seq) {
+            ev_arm(ev, sched_tick(sched, micros64()));
+        }
+    }
+}
+
+void sched_ev_stop(sched_t *sched) {
+    if (!sched) {
+        return;
+    }
+    sched_stop(sched);
+    if (sched->ev) {
+        ev_wakeup(sched);
+    }
+}
+
+void sched_ev_destroy(sched_t *sched) {
+    if (!sched) {
+        return;
+    }
+    if (sched->ev) {
+        ev_free(sched->ev);
+        sched->ev = NULL;
+    }
+    sched_destroy(sched);
+}
+
+#else
+
+int sched_ev_init(sched_t *sched, size_t max_tasks, size_t max_io) {
+    (void)sched;
+    (void)max_tasks;
+    (void)max_io;
+    logger_log(LOG_LEVEL_ERROR, "The event loop scheduler requires epoll.");
+    return -1;
+}
+
+int sched_ev_add_io(sched_t *sched, int fd, sched_io_fn fn, void *data, const char *name) {
+    (void)sched;
+    (void)fd;
+    (void)fn;
+    (void)data;
+    (void)name;
+    return -1;
+}
+
+void sched_ev_start(sched_t *sched) {
+    (void)sched;
+}
+
+void sched_ev_stop(sched_t *sched) {
+    sched_stop(sched);
+}
+
+void sched_ev_destroy(sched_t *sched) {
+    sched_destroy(sched);
+}
+
+#endif
+
+int sched_ev_add_serial(sched_t *sched, serial_t *serial, sched_io_fn fn, void *data, const char *name) {
+    return sched_ev_add_io(sched, serial ? serial->fd : -1, fn, data, name);
+}
+
+int sched_ev_add_udp(sched_t *sched, udp_t *udp, sched_io_fn fn, void *data, const char *name) {
+    return sched_ev_add_io(sched, udp ? udp->sockfd : -1, fn, data, name);
+}
+
+int sched_ev_add_pipe(sched_t *sched, ipc_pipe_t *pipe, sched_io_fn fn, void *data, const char *name) {
+    return sched_ev_add_io(sched, pipe ? pipe->fd : -1, fn, data, name);
+}
@@ -0,0 +1,112 @@
+#ifndef RJOS_SCHEDULER_EV_H
+#define RJOS_SCHEDULER_EV_H
+
+#include <stdint.h>
+
+#include "ipc.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "udp.h"
+
+/**
+ * Callback type of an I/O task.
+ *
+ * @param fd The descriptor that became ready.
+ * @param events The epoll events reported for the descriptor.
+ * @param data The user data passed at registration.
+ */
+typedef void (*sched_io_fn)(int fd, uint32_t events, void *data);
+
+/**
+ * Initializes a scheduler instance driven by an epoll event loop.
+ *
+ * Periodic tasks are added with sched_add_task() as usual and are released by
+ * a timerfd armed for the next due task. I/O tasks are registered against a
+ * descriptor and run as soon as it becomes readable, instead of polling it on
+ * a fixed interval. Only available on Linux.
+ *
+ * @param sched A pointer to the scheduler instance to initialize.
+ * @param max_tasks The maximum number of periodic tasks.
+ * @param max_io The maximum number of I/O tasks.
+ * @return Returns 0 on success, or -1 on failure or if epoll is not supported.
+ */
+int sched_ev_init(sched_t *sched, size_t max_tasks, size_t max_io);
+
+/**
+ * Registers an I/O task that runs whenever the descriptor is readable.
+ *
+ * The descriptor is watched level-triggered, so the callback is called again
+ * on the next loop iteration if it leaves data unread.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param fd The descriptor to watch.
+ * @param fn Callback to run on readiness.
+ * @param data User data passed to the callback.
+ * @param name Name of the task, used in log messages.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_ev_add_io(sched_t *sched, int fd, sched_io_fn fn, void *data, const char *name);
+
+/**
+ * Registers an I/O task on the descriptor of an open serial port.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param serial The serial port to watch.
+ * @param fn Callback to run when bytes are available.
+ * @param data User data passed to the callback.
+ * @param name Name of the task, used in log messages.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_ev_add_serial(sched_t *sched, serial_t *serial, sched_io_fn fn, void *data, const char *name);
+
+/**
+ * Registers an I/O task on the socket of a UDP connection.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param udp The UDP connection to watch.
+ * @param fn Callback to run when a datagram is available.
+ * @param data User data passed to the callback.
+ * @param name Name of the task, used in log messages.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_ev_add_udp(sched_t *sched, udp_t *udp, sched_io_fn fn, void *data, const char *name);
+
+/**
+ * Registers an I/O task on the descriptor of a named pipe.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param pipe The pipe to watch.
+ * @param fn Callback to run when a message is available.
+ * @param data User data passed to the callback.
+ * @param name Name of the task, used in log messages.
+ * @return Returns 0 on success, or -1 on failure.
+ */
+int sched_ev_add_pipe(sched_t *sched, ipc_pipe_t *pipe, sched_io_fn fn, void *data, const char *name);
+
+/**
+ * Runs the event loop until sched_ev_stop() is called or an exit condition is
+ * triggered.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_ev_start(sched_t *sched);
+
+/**
+ * Stops the event loop, waking it up if it is blocked in epoll_wait().
+ *
+ * Safe to call from another thread or a callback.
+ *
+ * @param sched Pointer to the scheduler instance.
+ */
+void sched_ev_stop(sched_t *sched);
+
+/**
+ * Closes the event loop descriptors and destroys the scheduler.
+ *
+ * The registered I/O descriptors are owned by the caller and stay open.
+ *
+ * @param sched Pointer to the scheduler instance to be destroyed.
+ */
+void sched_ev_destroy(sched_t *sched);
+
+#endif
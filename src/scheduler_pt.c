@@ -1,211 +1,824 @@
-#include <signal.h>
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
 #include "scheduler_pt.h"
+#include "config.h"
 #include "system.h"
 #include "logger.h"
+#include "util/sched_util.h"
+#include "util/steal_queue.h"
+
+/* Stack a worker keeps free below the prefaulted region for its own frames and the tasks. */
+#define PREFAULT_MARGIN (64 * 1024)
 
 /**
- * @brief Indicates if a shutdown has been requested.
- * @details This variable is set to 1 when a termination signal
- * is received, signaling the application to begin the shutdown process.
- * It remains 0 otherwise.
+ * @brief A worker thread together with the queue the dispatcher feeds it.
+ * @details Workers start on their own cache line, so that one worker taking
+ * from its queue does not invalidate the line of its neighbour.
  */
-static volatile sig_atomic_t shutdown_requested = 0;
+struct sched_worker {
+    _Alignas(SCHED_CACHE_LINE) pthread_t thread;
+    steal_queue_t      queue;
+    struct sched_pool *pool;
+    size_t             id;
+    int                rt_priority; /**< Priority the worker currently runs at */
+};
 
-static void handle_signal(int sig) {
-    (void)sig;
-    shutdown_requested = 1;
-}
+/**
+ * @brief Fixed-size pool of worker threads with per-worker queues.
+ * @details The dispatcher spreads due tasks round-robin over the worker
+ * queues. Each worker drains its own queue in the order the tasks were
+ * released and steals from the others when it runs dry, so a burst of
+ * simultaneously due tasks is spread across all cores even when one worker is
+ * stuck in a long callback. Every queue can hold all contexts, so a push never
+ * fails. Graph nodes made ready by a worker are handed over through a ring
+ * under the pool lock instead, as the queues have a single producer.
+ */
+struct sched_pool {
+    struct sched_worker *workers;
+    size_t               worker_count;  /**< Number of running workers */
+    size_t               worker_capacity;
+    size_t               next_worker;   /**< Round-robin cursor of the dispatcher */
+    sched_ctx_t         *contexts;      /**< SCHED_PT_MAX_INSTANCES contexts per task slot */
+    sched_pt_mode_t      mode;
+    sched_rt_attr_t      attr;
+    atomic_size_t        queued;        /**< Tasks pushed but not yet taken by a worker */
+    atomic_size_t        pending;       /**< Tasks pushed but not yet finished */
+    sched_node_t       **nodes;         /**< Ring of graph nodes handed over by workers, under lock */
+    size_t               node_head;
+    size_t               node_count;
+    size_t               node_capacity; /**< Total nodes of the registered graphs */
+    int                  shutdown;
+    pthread_mutex_t      lock;
+    pthread_cond_t       work_ready;
+    pthread_cond_t       work_done;
+};
 
 /**
- * @brief Synchronization mutex for scheduler operations.
- * @details Ensures thread-safe access to shared resources within the scheduler
- * by serializing operations that require mutual exclusion.
+ * @brief Runs one task on the calling worker.
+ * @details The counters are published under the per-task sequence lock, and
+ * the log message and hook run after it, so independent tasks never contend
+ * on a shared lock.
  */
-static pthread_mutex_t sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static void run_ctx(sched_ctx_t *ctx) {
+    sched_task_t *task = ctx->task;
+    uint64_t deadline_us = ctx->release_us + (uint64_t)task->interval_ms * 1000;
+
+    /* Concurrent instances of the task each keep their own start for the watchdog. */
+    unsigned instance = (unsigned)__builtin_ctz(ctx->instance);
+    uint64_t start_us = micros64();
+    sched_budget_begin(task, instance, start_us);
+    task->callback(task->data);
+    uint64_t end_us = micros64();
+    uint64_t duration_us = end_us - start_us;
+    sched_budget_end(ctx->sched, ctx->idx, instance, duration_us);
+
+    /*
+     * In overlapping mode a late run is accounted by the overrun policy at the
+     * next release. One-shots have no next release and so no deadline.
+     */
+    int overrun = !task->oneshot && ctx->sched->pool->mode == SCHED_PT_BARRIER && end_us > deadline_us;
+    seqlock_write_begin(&task->seq);
+    if (!task->oneshot) {
+        task->deadline_ms = (uint32_t)(deadline_us / 1000);
+    }
+    task->last_run_ms = (uint32_t)(ctx->now_us / 1000);
+    task->run_count++;
+    task->total_duration_us += duration_us;
+    if (duration_us > task->max_duration_us) {
+        task->max_duration_us = (uint32_t)duration_us;
+    }
+    if (overrun) {
+        task->overrun_count++;
+    }
+    seqlock_write_end(&task->seq);
+
+    if (overrun) {
+        LOG_RATELIMITED(LOG_LEVEL_INFO, LOGGER_RATE, LOGGER_BURST,
+            "Task %s exceeded deadline by %ums.", task->name,
+            (uint32_t)((end_us - deadline_us) / 1000));
+    }
+    LOG_TRACE("Task %s released at %lluus ran for %lluus.", task->name,
+        (unsigned long long)ctx->release_us, (unsigned long long)duration_us);
+    sched_t *sched = ctx->sched;
+    if (sched->log_hook) {
+        sched->log_hook(ctx->idx, task->data);
+    }
+}
 
 /**
- * @brief Comparison function for sorting scheduler tasks by priority.
- * @details Compares two scheduler task objects by their priority values.
- * The function returns:
- * - A negative value if the priority of the first task is less than the second.
- * - A positive value if the priority of the first task is greater than the second.
- * - Zero if both tasks have the same priority.
- *
- * This function is designed to be utilized with sorting algorithms such as qsort.
+ * @brief Releases the instance of a finished run.
+ * @details If SCHED_OVERRUN_QUEUE parked a release while the run executed,
+ * the instance is kept and the caller runs the task once more.
  *
- * @param a Pointer to the first sched_task_t object.
- * @param b Pointer to the second sched_task_t object.
- * @return Integer representing the relative priority of the two tasks.
- */
-static int sched_task_cmp(const void *a, const void *b) {
-    const sched_task_t *ta = (const sched_task_t *)a;
-    const sched_task_t *tb = (const sched_task_t *)b;
-    if (ta->priority < tb->priority) return -1;
-    if (ta->priority > tb->priority) return  1;
+ * @return Non-zero if the caller must run the task again with the same context.
+ */
+static int finish_ctx(sched_ctx_t *ctx) {
+    sched_task_t *task = ctx->task;
+    unsigned expected = 1;
+    if (atomic_compare_exchange_strong(&task->queued, &expected, 0)) {
+        return 1;
+    }
+    atomic_fetch_and(&task->instances, ~ctx->instance);
+
+    /*
+     * A release may have been queued between the check and the release of the
+     * instance. Take the instance back for it, unless the dispatcher already
+     * started a new run that will pick the queued release up on completion.
+     */
+    if (!atomic_load(&task->queued)) {
+        return 0;
+    }
+    unsigned idle = 0;
+    if (!atomic_compare_exchange_strong(&task->instances, &idle, ctx->instance)) {
+        return 0;
+    }
+    expected = 1;
+    if (atomic_compare_exchange_strong(&task->queued, &expected, 0)) {
+        return 1;
+    }
+    atomic_fetch_and(&task->instances, ~ctx->instance);
     return 0;
 }
 
 /**
- * @brief Sorts the tasks in the scheduler by priority.
- * @details This function organizes the tasks in the scheduler structure in
- * descending order of priority, ensuring that higher-priority tasks are scheduled first.
- *
- * @param sched Pointer to the scheduler structure that contains the task list to be sorted.
+ * @brief Takes a task from the worker's own queue, or steals one from a peer.
  */
-static void sort_tasks_by_priority(sched_t *sched) {
-    qsort(sched->tasks, sched->tasks_count, sizeof(sched_task_t), sched_task_cmp);
+static sched_ctx_t *pool_take(struct sched_pool *pool, size_t id) {
+    for (size_t k = 0; k < pool->worker_count; k++) {
+        sched_ctx_t *ctx = steal_queue_steal(&pool->workers[(id + k) % pool->worker_count].queue);
+        if (ctx) {
+            atomic_fetch_sub(&pool->queued, 1);
+            return ctx;
+        }
+    }
+    return NULL;
 }
 
-static void *sched_task_thread(void *arg) {
-    sched_ctx_t *ctx = (sched_ctx_t *)arg;
+/**
+ * @brief Touches the given amount of stack so it is mapped before any task runs.
+ */
+static void __attribute__((noinline)) prefault_stack(size_t bytes) {
+    volatile unsigned char buf[bytes];
+    for (size_t i = 0; i < bytes; i += 4096) {
+        buf[i] = 0;
+    }
+    /* Keep the stores from being optimized away. */
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+}
 
-    /* Lock for status update. */
-    sched_task_t *task = ctx->task;
-    pthread_mutex_lock(&sched_mutex);
-    task->deadline_ms = task->last_run_ms + task->interval_ms;
-    pthread_mutex_unlock(&sched_mutex);
+/**
+ * @brief Moves the worker to the real-time priority matching the task priority.
+ * @details The 0-255 task priority is scaled onto the priority range of the
+ * worker policy. The switch is skipped if the worker already runs at it.
+ */
+static void apply_task_priority(struct sched_worker *worker, const sched_task_t *task) {
+    int policy = worker->pool->attr.policy;
+    int min = sched_get_priority_min(policy);
+    int max = sched_get_priority_max(policy);
+    int priority = min + (int)task->priority * (max - min) / 255;
+    if (priority == worker->rt_priority) {
+        return;
+    }
+    struct sched_param param = { .sched_priority = priority };
+    if (pthread_setschedparam(pthread_self(), policy, &param) == 0) {
+        worker->rt_priority = priority;
+    }
+}
 
-    uint32_t start = millis();
-    task->callback(task->data);
-    uint32_t duration = millis() - start;
+/**
+ * @brief Hands a ready graph node over to an idle worker.
+ * @details The worker queues only accept pushes from the dispatcher, so
+ * nodes made ready by a worker go through a ring under the pool lock. A node is in the
+ * ring at most once per release and releases of a graph never overlap, so
+ * the ring sized to all nodes cannot overflow.
+ */
+static void pool_push_node(struct sched_pool *pool, sched_node_t *node) {
+    pthread_mutex_lock(&pool->lock);
+    pool->nodes[(pool->node_head + pool->node_count++) % pool->node_capacity] = node;
+    atomic_fetch_add(&pool->pending, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
 
-    uint32_t now_ms = ctx->now_ms;
-    pthread_mutex_lock(&sched_mutex);
-    task->last_run_ms = now_ms;
-    task->run_count++;
-    task->total_duration_ms += duration;
-    if (duration > task->max_duration_ms) {
-        task->max_duration_ms = duration;
+/**
+ * @brief Takes a node from the ring. Called with the pool lock held.
+ */
+static sched_node_t *pool_take_node(struct sched_pool *pool) {
+    if (pool->node_count == 0) {
+        return NULL;
     }
-    if (millis() > task->deadline_ms) {
-        task->overrun_count++;
-        logger_log(LOG_LEVEL_INFO, "Task %s exceeded deadline by %ums.", task->name, millis() - task->deadline_ms);
+    sched_node_t *node = pool->nodes[pool->node_head];
+    pool->node_head = (pool->node_head + 1) % pool->node_capacity;
+    pool->node_count--;
+    atomic_fetch_sub(&pool->queued, 1);
+    return node;
+}
+
+/**
+ * @brief Runs a graph node, then the downstream nodes it makes ready.
+ * @details The first downstream node that becomes ready runs next on the
+ * same worker; the others are handed over to idle workers.
+ */
+static void run_nodes(struct sched_pool *pool, sched_node_t *node) {
+    while (node) {
+        sched_graph_t *graph = node->graph;
+        uint64_t start_us = micros64();
+        node->callback(node->data);
+        uint64_t end_us = micros64();
+        uint64_t duration_us = end_us - start_us;
+        node->run_count++;
+        node->total_duration_us += duration_us;
+        if (duration_us > node->max_duration_us) {
+            node->max_duration_us = (uint32_t)duration_us;
+        }
+
+        sched_node_t *next = NULL;
+        for (size_t i = 0; i < node->downstream_count; i++) {
+            sched_node_t *down = &graph->nodes[node->downstream[i]];
+            if (atomic_fetch_sub(&down->pending, 1) == 1) {
+                if (!next) {
+                    next = down;
+                } else {
+                    pool_push_node(pool, down);
+                }
+            }
+        }
+        if (atomic_fetch_sub(&graph->remaining, 1) == 1) {
+            /* Last node of the release. */
+            hist_record(&graph->latency, end_us - graph->start_us);
+            atomic_store(&graph->busy, 0);
+        }
+        node = next;
     }
-    sched_t *sched = ctx->sched;
-    size_t idx = ctx->idx;
-    if (sched->log_hook) {
-        sched->log_hook(idx, task->data);
+}
+
+/**
+ * @brief Periodic task starting a release of a task graph.
+ */
+static void graph_release(void *data) {
+    sched_graph_t *graph = data;
+    if (atomic_exchange(&graph->busy, 1)) {
+        /* Overlapping releases may be dropped by several workers at once. */
+        atomic_fetch_add(&graph->skip_count, 1);
+        return;
+    }
+    graph->start_us = micros64();
+    graph->releases++;
+    if (graph->node_count == 0) {
+        atomic_store(&graph->busy, 0);
+        return;
     }
-    pthread_mutex_unlock(&sched_mutex);
 
-    free(ctx);
+    /* Arm every node before starting any, the first root runs here. */
+    for (size_t i = 0; i < graph->node_count; i++) {
+        atomic_store(&graph->nodes[i].pending, graph->nodes[i].upstream_count);
+    }
+    atomic_store(&graph->remaining, (unsigned)graph->node_count);
+    sched_node_t *first = NULL;
+    for (size_t i = 0; i < graph->node_count; i++) {
+        if (graph->nodes[i].upstream_count == 0) {
+            if (!first) {
+                first = &graph->nodes[i];
+            } else {
+                pool_push_node(graph->sched->pool, &graph->nodes[i]);
+            }
+        }
+    }
+    run_nodes(graph->sched->pool, first);
+}
+
+/**
+ * @brief Marks a unit of pushed work finished, waking a waiting dispatcher.
+ */
+static void pool_done(struct sched_pool *pool) {
+    if (atomic_fetch_sub(&pool->pending, 1) == 1) {
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->work_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void *sched_worker_thread(void *arg) {
+    struct sched_worker *worker = arg;
+    struct sched_pool *pool = worker->pool;
+
+    if (pool->attr.prefault) {
+        prefault_stack(pool->attr.prefault);
+    }
+
+    for (;;) {
+        sched_ctx_t *ctx = pool_take(pool, worker->id);
+        if (!ctx) {
+            /* Take a handed-over graph node, or sleep until more work is published. */
+            pthread_mutex_lock(&pool->lock);
+            sched_node_t *node;
+            while (!(node = pool_take_node(pool)) && atomic_load(&pool->queued) == 0 && !pool->shutdown) {
+                pthread_cond_wait(&pool->work_ready, &pool->lock);
+            }
+            int done = !node && atomic_load(&pool->queued) == 0 && pool->shutdown;
+            pthread_mutex_unlock(&pool->lock);
+            if (node) {
+                run_nodes(pool, node);
+                pool_done(pool);
+            }
+            if (done) {
+                break;
+            }
+            continue;
+        }
+
+        if (pool->attr.task_priority) {
+            apply_task_priority(worker, ctx->task);
+        }
+        run_ctx(ctx);
+        while (finish_ctx(ctx)) {
+            /* The queued run belongs to the release after the one just served. */
+            ctx->release_us += (uint64_t)ctx->task->interval_ms * 1000;
+            ctx->now_us = micros64();
+            run_ctx(ctx);
+        }
+        pool_done(pool);
+    }
     return NULL;
 }
 
-int sched_init(sched_t *sched, size_t max_tasks) {
-    sched->tasks = calloc(max_tasks, sizeof(sched_task_t));
-    if (!sched->tasks) {
+/**
+ * @brief Pushes a preallocated context onto the next worker queue.
+ * @details Only the dispatcher thread pushes, so it is the single producer
+ * of every queue.
+ */
+static void pool_push(struct sched_pool *pool, sched_ctx_t *ctx) {
+    atomic_fetch_add(&pool->pending, 1);
+    atomic_fetch_add(&pool->queued, 1);
+    size_t w = pool->next_worker;
+    pool->next_worker = (w + 1) % pool->worker_count;
+    /* Every queue can hold all contexts, so the push cannot fail. */
+    (void)steal_queue_push(&pool->workers[w].queue, ctx);
+}
+
+/**
+ * @brief Wakes the workers for the tasks pushed since the last call.
+ */
+static void pool_signal(struct sched_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * @brief Blocks until every queued context has finished running.
+ */
+static void pool_wait_idle(struct sched_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (atomic_load(&pool->pending) > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void pool_destroy(struct sched_pool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->worker_count; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+    }
+    if (pool->workers) {
+        for (size_t i = 0; i < pool->worker_capacity; i++) {
+            steal_queue_destroy(&pool->workers[i].queue);
+        }
+    }
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->work_done);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool->contexts);
+    free(pool->nodes);
+    free(pool);
+}
+
+void sched_rt_attr_init(sched_rt_attr_t *attr) {
+    memset(attr, 0, sizeof(*attr));
+    attr->policy = SCHED_OTHER;
+}
+
+int sched_rt_attr_from_config(sched_rt_attr_t *attr) {
+    const char *val;
+    if ((val = config_get("sched_policy"))) {
+        if (strcmp(val, "fifo") == 0) {
+            attr->policy = SCHED_FIFO;
+        } else if (strcmp(val, "rr") == 0) {
+            attr->policy = SCHED_RR;
+        } else if (strcmp(val, "other") == 0) {
+            attr->policy = SCHED_OTHER;
+        } else {
+            logger_log(LOG_LEVEL_ERROR, "Invalid sched_policy: %s.", val);
+            return -1;
+        }
+    }
+    if ((val = config_get("sched_priority"))) {
+        attr->priority = atoi(val);
+    }
+    if ((val = config_get("sched_task_priority"))) {
+        attr->task_priority = atoi(val) != 0;
+    }
+    if ((val = config_get("sched_cpus")) && sched_parse_cpus(val, &attr->cpus) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid sched_cpus: %s.", val);
         return -1;
     }
-    sched->max_tasks = max_tasks;
-    sched->tasks_count = 0;
-    sched->running = 0;
-    sched->log_hook = NULL;
+    if ((val = config_get("sched_pin_workers"))) {
+        attr->pin_workers = atoi(val) != 0;
+    }
+    if ((val = config_get("sched_stack_kb"))) {
+        attr->stack_size = strtoul(val, NULL, 10) * 1024;
+    }
+    if ((val = config_get("sched_prefault_kb"))) {
+        attr->prefault = strtoul(val, NULL, 10) * 1024;
+    }
     return 0;
 }
 
-int sched_add_task(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name) {
-    if (!sched || !fn || sched->tasks_count >= sched->max_tasks) {
+/**
+ * @brief Prepares the thread attributes of one worker.
+ *
+ * @return Returns 0 on success, or -1 if an attribute is rejected.
+ */
+static int worker_attr(pthread_attr_t *pattr, const sched_rt_attr_t *attr, size_t id) {
+    if (attr->stack_size && pthread_attr_setstacksize(pattr, attr->stack_size) != 0) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid worker stack size: %zu.", attr->stack_size);
         return -1;
     }
-    sched_task_t *task = &sched->tasks[sched->tasks_count++];
-    task->callback = fn;
-    task->data = data;
-    task->name = strdup(name);
-    task->interval_ms = interval_ms;
-    task->last_run_ms = millis();
-    task->priority = priority;
-    task->run_count = 0;
-    task->total_duration_ms = 0;
-    task->max_duration_ms = 0;
-    task->overrun_count = 0;
+    if (attr->prefault) {
+        /* The prefault is a stack buffer, so it has to fit in the stack the worker really gets. */
+        size_t stack_size = 0;
+        if (pthread_attr_getstacksize(pattr, &stack_size) != 0 || stack_size <= PREFAULT_MARGIN ||
+            attr->prefault > stack_size - PREFAULT_MARGIN) {
+            logger_log(LOG_LEVEL_ERROR, "Worker stack prefault of %zu bytes does not fit a %zu byte stack.",
+                attr->prefault, stack_size);
+            return -1;
+        }
+    }
+    if (attr->policy != SCHED_OTHER) {
+        struct sched_param param = { .sched_priority = attr->priority };
+        if (pthread_attr_setinheritsched(pattr, PTHREAD_EXPLICIT_SCHED) != 0 ||
+            pthread_attr_setschedpolicy(pattr, attr->policy) != 0 ||
+            pthread_attr_setschedparam(pattr, &param) != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Invalid worker priority: %d.", attr->priority);
+            return -1;
+        }
+    }
+    if (attr->cpus) {
+        int rc;
+        if (attr->pin_workers) {
+            /* Worker i takes the i-th CPU of the mask, wrapping around. */
+            size_t nth = id % (size_t)__builtin_popcountll(attr->cpus);
+            uint64_t cpus = attr->cpus;
+            while (nth--) {
+                cpus &= cpus - 1;
+            }
+            rc = sched_attr_pin_cpu(pattr, __builtin_ctzll(cpus));
+        } else {
+            rc = sched_attr_set_cpus(pattr, attr->cpus);
+        }
+        if (rc != 0) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to set worker CPU affinity.");
+            return -1;
+        }
+    }
     return 0;
 }
 
-void sched_start(sched_t *sched) {
-    sched->running = 1;
-    sort_tasks_by_priority(sched);
+static struct sched_pool *pool_create(size_t capacity, size_t workers, const sched_rt_attr_t *attr) {
+    if (workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    struct sched_pool *pool = calloc(1, sizeof(struct sched_pool));
+    if (!pool) {
+        return NULL;
+    }
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->pending, 0);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+    if (attr) {
+        pool->attr = *attr;
+    } else {
+        sched_rt_attr_init(&pool->attr);
+    }
+    capacity *= SCHED_PT_MAX_INSTANCES;
+    pool->workers  = sched_calloc_aligned(workers, sizeof(struct sched_worker));
+    pool->contexts = calloc(capacity, sizeof(sched_ctx_t));
+    if (!pool->workers || !pool->contexts) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    pool->worker_capacity = workers;
+    for (size_t i = 0; i < workers; i++) {
+        if (steal_queue_init(&pool->workers[i].queue, capacity) != 0) {
+            pool_destroy(pool);
+            return NULL;
+        }
+        pool->workers[i].pool = pool;
+        pool->workers[i].id   = i;
+        pool->workers[i].rt_priority = pool->attr.priority;
+    }
+    for (size_t i = 0; i < workers; i++) {
+        pthread_attr_t pattr;
+        pthread_attr_init(&pattr);
+        int rc = worker_attr(&pattr, &pool->attr, i);
+        if (rc == 0) {
+            rc = pthread_create(&pool->workers[i].thread, &pattr, sched_worker_thread, &pool->workers[i]);
+            if (rc != 0) {
+                logger_log(LOG_LEVEL_ERROR, "Failed to create worker thread: %s.", strerror(rc));
+            }
+        }
+        pthread_attr_destroy(&pattr);
+        if (rc != 0) {
+            pool_destroy(pool);
+            return NULL;
+        }
+        pool->worker_count++;
+    }
+    return pool;
+}
+
+int sched_pt_init(sched_t *sched, size_t max_tasks, size_t workers) {
+    return sched_pt_init_attr(sched, max_tasks, workers, NULL);
+}
+
+int sched_pt_init_attr(sched_t *sched, size_t max_tasks, size_t workers, const sched_rt_attr_t *attr) {
+    if (sched_init(sched, max_tasks) != 0) {
+        return -1;
+    }
+    sched->pool = pool_create(max_tasks, workers, attr);
+    if (!sched->pool) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to create scheduler worker pool.");
+        sched_destroy(sched);
+        return -1;
+    }
+    return 0;
+}
+
+int sched_pt_set_mode(sched_t *sched, sched_pt_mode_t mode) {
+    if (!sched || !sched->pool) {
+        logger_log(LOG_LEVEL_ERROR, "Scheduler has no worker pool, use sched_pt_init().");
+        return -1;
+    }
+    sched->pool->mode = mode;
+    return 0;
+}
+
+int sched_pt_set_overrun(sched_t *sched, sched_overrun_t policy, unsigned max_instances) {
+    if (!sched) {
+        return -1;
+    }
+    if (policy != SCHED_OVERRUN_CONCURRENT) {
+        max_instances = 1;
+    }
+    if (max_instances == 0 || max_instances > SCHED_PT_MAX_INSTANCES) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid instance limit: %u.", max_instances);
+        return -1;
+    }
+    sched->overrun_policy = policy;
+    sched->max_instances = (uint8_t)max_instances;
+    return 0;
+}
 
-    pthread_t *worker_threads = calloc(sched->tasks_count, sizeof(pthread_t));
-    if (!worker_threads) {
+/**
+ * @brief Applies the overrun policy to a release and pushes a run if it is allowed.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param idx Index of the released task.
+ * @param now_us Timestamp of the current tick.
+ * @param release_us The release being served.
+ */
+static void dispatch(sched_t *sched, size_t idx, uint64_t now_us, uint64_t release_us) {
+    struct sched_pool *pool = sched->pool;
+    sched_task_t *task = &sched->tasks[idx];
+    unsigned limit = task->overrun_policy == SCHED_OVERRUN_CONCURRENT ? task->max_instances : 1;
+
+    /* Claim the lowest free instance bit, unless the limit is reached. */
+    unsigned mask = atomic_load(&task->instances);
+    unsigned bit;
+    for (;;) {
+        if ((unsigned)__builtin_popcount(mask) >= limit) {
+            bit = 0;
+            break;
+        }
+        bit = ~mask & (mask + 1);
+        if (atomic_compare_exchange_weak(&task->instances, &mask, mask | bit)) {
+            break;
+        }
+    }
+
+    int dropped = 0;
+    if (!bit) {
+        unsigned expected = 0;
+        dropped = task->overrun_policy != SCHED_OVERRUN_QUEUE ||
+            !atomic_compare_exchange_strong(&task->queued, &expected, 1);
+    }
+    if (mask != 0) {
+        seqlock_write_begin(&task->seq);
+        task->overrun_count++;
+        if (dropped) {
+            task->skip_count++;
+        }
+        seqlock_write_end(&task->seq);
+    }
+    if (!bit) {
+        return;
+    }
+
+    /* Hand the run to the workers through its preallocated context. */
+    sched_ctx_t *ctx = &pool->contexts[idx * SCHED_PT_MAX_INSTANCES + (size_t)__builtin_ctz(bit)];
+    ctx->sched      = sched;
+    ctx->task       = task;
+    ctx->idx        = idx;
+    ctx->now_us     = now_us;
+    ctx->release_us = release_us;
+    ctx->instance   = bit;
+    pool_push(pool, ctx);
+}
+
+void sched_pt_start(sched_t *sched) {
+    if (!sched) {
         return;
     }
+    if (!sched->pool) {
+        sched->pool = pool_create(sched->max_tasks, 0, NULL);
+        if (!sched->pool) {
+            logger_log(LOG_LEVEL_ERROR, "Failed to create scheduler worker pool.");
+            return;
+        }
+    }
+    struct sched_pool *pool = sched->pool;
+    atomic_store(&sched->running, 1);
+    sched_apply_timer_slack(sched);
+    sched_drain_submissions(sched, micros64());
+    sort_tasks_by_priority(sched);
+    if (sched->stagger) {
+        sched_stagger(sched);
+    }
+
+    while (atomic_load(&sched->running) && !sched_should_exit()) {
+        uint64_t now_us      = micros64();
+        uint64_t next_due_us = UINT64_MAX;
+
+        sched_drain_submissions(sched, now_us);
+
+        /* Collect the released tasks in priority order, then let the policy reorder them. */
+        size_t released = 0;
+        for (size_t i = 0; i < sched->order_count; i++) {
+            uint64_t due_us = sched->due_us[sched->order[i]];
+            if (now_us >= due_us) {
+                sched->ready[released++].idx = sched->order[i];
+            } else if (due_us != UINT64_MAX && due_us - now_us < next_due_us) {
+                next_due_us = due_us - now_us;
+            }
+        }
+        sched_order_ready(sched, sched->ready, released);
+
+        for (size_t i = 0; i < released; i++) {
+            size_t idx = sched->ready[i].idx;
+            sched_task_t *task = &sched->tasks[idx];
+            /* The dispatcher is the only writer of the release time. */
+            uint64_t release_us = task->release_us;
+            dispatch(sched, idx, now_us, release_us);
+            if (task->oneshot) {
+                /* The slot is freed once the run completes. */
+                sched_retire_task(sched, idx);
+                continue;
+            }
 
-    while (!sched_should_exit()) {
-        uint32_t now_ms      = millis();
-        uint32_t next_due_ms = UINT32_MAX;
-
-        size_t thread_count = 0;
-        for (size_t i = 0; i < sched->tasks_count; i++) {
-            sched_task_t *task = &sched->tasks[i];
-            pthread_mutex_lock(&sched_mutex);
-            uint32_t elapsed_ms = now_ms - task->last_run_ms;
-            pthread_mutex_unlock(&sched_mutex);
-
-            if (elapsed_ms >= task->interval_ms) {
-                /* Prepare thread args. */
-                sched_ctx_t *ctx = malloc(sizeof(sched_ctx_t));
-                ctx->sched  = sched;
-                ctx->task   = task;
-                ctx->now_ms = now_ms;
-                ctx->idx    = i;
-
-                /* Start the thread. */
-                if (pthread_create(&worker_threads[thread_count++], NULL, sched_task_thread, ctx) != 0) {
-                    free(ctx);
-                    continue;
+            uint64_t interval_us = (uint64_t)task->interval_ms * 1000;
+            uint32_t missed = 0;
+            if (pool->mode == SCHED_PT_OVERLAP) {
+                /* Stay on the release grid, dropping releases the dispatcher slept through. */
+                release_us += interval_us;
+                if (release_us <= now_us && interval_us) {
+                    missed = (uint32_t)((now_us - release_us) / interval_us + 1);
+                    release_us += (uint64_t)missed * interval_us;
                 }
             } else {
-                uint32_t diff_ms = task->interval_ms - elapsed_ms;
-                if (diff_ms < next_due_ms) {
-                    next_due_ms = diff_ms;
-                }
+                /* The task is released again one interval after this tick. */
+                release_us = now_us + interval_us;
+            }
+            seqlock_write_begin(&task->seq);
+            task->release_us = release_us;
+            task->skip_count += missed;
+            seqlock_write_end(&task->seq);
+            sched->due_us[idx] = release_us;
+
+            uint64_t wait_us = release_us > now_us ? release_us - now_us : 0;
+            if (wait_us < next_due_us) {
+                next_due_us = wait_us;
             }
         }
-        /* Wait for all threads to finish before the next scheduler ticks. */
-        for (size_t i = 0; i < thread_count; i++) {
-            pthread_join(worker_threads[i], NULL);
+        pool_signal(pool);
+
+        if (pool->mode == SCHED_PT_BARRIER) {
+            /* Wait for all dispatched tasks to finish before the next scheduler tick. */
+            pool_wait_idle(pool);
         }
-        uint32_t usleep_mul = (next_due_ms == UINT32_MAX) ? 1 : next_due_ms;
-        usleep(usleep_mul * 1);
+
+        if (next_due_us == UINT64_MAX) {
+            next_due_us = 100;
+        }
+        sched_sleep_until(sched, now_us + next_due_us);
     }
-    free(worker_threads);
+    /* Let the runs still in flight complete before returning. */
+    pool_wait_idle(pool);
 }
 
-void sched_stop(sched_t *sched) {
-    sched->running = 0;
+int sched_graph_init(sched_graph_t *graph, size_t max_nodes) {
+    if (!graph) {
+        return -1;
+    }
+    memset(graph, 0, sizeof(*graph));
+    graph->nodes = calloc(max_nodes ? max_nodes : 1, sizeof(sched_node_t));
+    if (!graph->nodes) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for task graph nodes.");
+        return -1;
+    }
+    graph->max_nodes = max_nodes;
+    hist_reset(&graph->latency);
+    return 0;
 }
 
-void sched_destroy(sched_t *sched) {
-    for (size_t i = 0; i < sched->tasks_count; ++i) {
-        free(sched->tasks[i].name);
+int sched_graph_add_node(sched_graph_t *graph, task_fn fn, void *data, const char *name) {
+    if (!graph || !fn || graph->node_count >= graph->max_nodes) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to add task graph node: %s.", name);
+        return -1;
     }
-    free(sched->tasks);
-    sched->tasks = NULL;
-    sched->max_tasks   = 0;
-    sched->tasks_count = 0;
+    sched_node_t *node = &graph->nodes[graph->node_count];
+    snprintf(node->name, sizeof(node->name), "%s", name ? name : "");
+    node->callback = fn;
+    node->data = data;
+    node->graph = graph;
+    return (int)graph->node_count++;
 }
 
-void sched_set_log_hook(sched_t *sched, sched_log_fn log_hook) {
-    if (sched) {
-        sched->log_hook = log_hook;
+int sched_graph_add_edge(sched_graph_t *graph, int from, int to) {
+    if (!graph || from < 0 || to <= from || (size_t)to >= graph->node_count) {
+        logger_log(LOG_LEVEL_ERROR, "Invalid task graph edge %d -> %d.", from, to);
+        return -1;
     }
+    sched_node_t *up = &graph->nodes[from];
+    if (up->downstream_count >= SCHED_NODE_MAX_DOWNSTREAM) {
+        logger_log(LOG_LEVEL_ERROR, "Task graph node %s has too many downstream nodes.", up->name);
+        return -1;
+    }
+    up->downstream[up->downstream_count++] = (size_t)to;
+    graph->nodes[to].upstream_count++;
+    return 0;
 }
 
-int sched_should_exit(void) {
-    return shutdown_requested != 0;
+int sched_pt_add_graph(sched_t *sched, sched_graph_t *graph, uint32_t interval_ms, uint8_t priority, const char *name) {
+    if (!sched || !sched->pool || !graph) {
+        logger_log(LOG_LEVEL_ERROR, "Scheduler has no worker pool, use sched_pt_init().");
+        return -1;
+    }
+    struct sched_pool *pool = sched->pool;
+    sched_node_t **nodes = realloc(pool->nodes, (pool->node_capacity + graph->max_nodes + 1) * sizeof(sched_node_t *));
+    if (!nodes) {
+        logger_log(LOG_LEVEL_ERROR, "Failed to allocate memory for task graph %s.", name);
+        return -1;
+    }
+    pool->nodes = nodes;
+    pool->node_capacity += graph->max_nodes + 1;
+    graph->sched = sched;
+    return sched_add_task(sched, graph_release, graph, interval_ms, priority, name);
 }
 
-void sched_setup_signal_handlers(void) {
-    struct sigaction sa;
-    sa.sa_handler = handle_signal;
-    sa.sa_flags   = 0;
-    sigemptyset(&sa.sa_mask);
-    (void)sigaction(SIGINT,  &sa, NULL);
-    (void)sigaction(SIGTERM, &sa, NULL);
-}
\ No newline at end of file
+void sched_graph_destroy(sched_graph_t *graph) {
+    if (graph) {
+        free(graph->nodes);
+        graph->nodes = NULL;
+        graph->node_count = 0;
+        graph->max_nodes = 0;
+    }
+}
+
+void sched_pt_destroy(sched_t *sched) {
+    if (!sched) {
+        return;
+    }
+    if (sched->pool) {
+        pool_destroy(sched->pool);
+        sched->pool = NULL;
+    }
+    sched_destroy(sched);
+}
@@ -3,163 +3,249 @@
 
 #include <stdint.h>
 
-typedef void (*task_fn)(void *data);
-typedef void (*sched_log_fn)(size_t idx, void *data);
+#include "scheduler.h"
 
-/**
- * Struct representing a scheduled task in the system.
- */
-typedef struct sched_task {
-    char    *name;
-    task_fn  callback;      /**< Function to execute */
-    void    *data;          /**< Arguments of the function to execute */
-    uint32_t interval_ms;   /**< Execution interval in milliseconds */
-    uint32_t last_run_ms;   /**< Timestamp of last execution */
-    uint8_t  priority;      /**< 0 = Lowest, 255 = Highest */
-    uint32_t run_count;
-    uint32_t total_duration_ms;
-    uint32_t max_duration_ms;
-    uint32_t deadline_ms;
-    uint32_t overrun_count;
-} sched_task_t;
+/** Upper bound of the instances of a task running at the same time. */
+#define SCHED_PT_MAX_INSTANCES SCHED_MAX_INSTANCES
+
+/** Maximum number of downstream nodes of a task graph node. */
+#define SCHED_NODE_MAX_DOWNSTREAM 8
 
 /**
- * Struct representing a scheduler for managing and executing tasks.
+ * Enumeration of the execution modes of the threaded scheduler.
  */
-typedef struct sched {
-    sched_task_t *tasks;
-    size_t        max_tasks;
-    size_t        tasks_count;
-    int           running;
-    sched_log_fn  log_hook;
-} sched_t;
+typedef enum sched_pt_mode {
+    SCHED_PT_BARRIER = 0,   /**< Each tick waits until every task it released has finished */
+    SCHED_PT_OVERLAP = 1,   /**< Every task follows its own release timeline */
+} sched_pt_mode_t;
 
 /**
  * Struct representing the context for a scheduling operation.
  *
  * This structure contains information about the scheduler instance,
  * the specific scheduled task being processed, the task index within
- * the scheduler, and the current timestamp.
+ * the scheduler, and the current timestamp. SCHED_PT_MAX_INSTANCES contexts
+ * are preallocated per task slot, so dispatching a task never allocates.
  */
 typedef struct sched_ctx {
     sched_t      *sched;
     sched_task_t *task;
     size_t        idx;
-    uint32_t      now_ms;
+    uint64_t      now_us;
+    uint64_t      release_us;   /**< Release this run belongs to */
+    unsigned      instance;     /**< Bit of this run in the task instance mask */
 } sched_ctx_t;
 
 /**
- * Initializes a scheduler instance with a specified maximum number of tasks.
+ * Struct representing a node of a task graph.
+ */
+typedef struct sched_node {
+    char         name[SCHED_TASK_NAME_LEN];
+    task_fn      callback;
+    void        *data;
+    struct sched_graph *graph;
+    unsigned     upstream_count;
+    atomic_uint  pending;       /**< Upstream nodes not yet completed in the current release */
+    size_t       downstream[SCHED_NODE_MAX_DOWNSTREAM];
+    size_t       downstream_count;
+    uint32_t     run_count;
+    uint64_t     total_duration_us;
+    uint32_t     max_duration_us;
+} sched_node_t;
+
+/**
+ * Struct representing a task graph: a pipeline of nodes released together,
+ * each node starting as soon as all of its upstream nodes have completed.
+ */
+typedef struct sched_graph {
+    sched_node_t *nodes;
+    size_t        node_count;
+    size_t        max_nodes;
+    sched_t      *sched;
+    atomic_uint   remaining;    /**< Nodes not yet completed in the current release */
+    atomic_int    busy;         /**< Non-zero while a release is in progress */
+    uint64_t      start_us;     /**< Start of the current release */
+    uint32_t      releases;
+    atomic_uint   skip_count;   /**< Releases dropped because the previous one was still running */
+    hist_t        latency;      /**< Release start to completion of the last node, in microseconds */
+} sched_graph_t;
+
+/**
+ * Struct representing the OS scheduling attributes of the worker threads.
+ */
+typedef struct sched_rt_attr {
+    int      policy;        /**< SCHED_OTHER, SCHED_FIFO or SCHED_RR */
+    int      priority;      /**< Static priority of the workers under SCHED_FIFO and SCHED_RR */
+    int      task_priority; /**< Non-zero to run each task at its own priority, mapped onto the policy range */
+    uint64_t cpus;          /**< Affinity mask of the workers, bit n for CPU n, 0 for no restriction */
+    int      pin_workers;   /**< Non-zero to pin worker i to the i-th CPU of the mask */
+    size_t   stack_size;    /**< Worker stack size in bytes, 0 for the default */
+    size_t   prefault;      /**< Bytes of stack each worker touches before it takes work, at least 64 KiB below the stack size */
+} sched_rt_attr_t;
+
+/**
+ * Initializes the worker attributes to the defaults of a normal thread.
+ *
+ * @param attr Pointer to the attributes to initialize.
+ */
+void sched_rt_attr_init(sched_rt_attr_t *attr);
+
+/**
+ * Reads the worker attributes from the loaded configuration.
+ *
+ * Recognized keys are sched_policy (other, fifo or rr), sched_priority,
+ * sched_task_priority, sched_cpus (e.g. 2-3,5), sched_pin_workers,
+ * sched_stack_kb and sched_prefault_kb. Missing keys keep their defaults.
+ *
+ * @param attr Pointer to the attributes to fill.
+ * @return Returns 0 on success, or -1 if a value is invalid.
+ */
+int sched_rt_attr_from_config(sched_rt_attr_t *attr);
+
+/**
+ * Initializes a scheduler instance together with a persistent worker pool.
+ *
+ * The workers are created once and each has a queue fed by the dispatcher,
+ * so the threaded scheduler does not create a thread per task per tick. Due
+ * tasks are spread round-robin over the queues and idle workers steal from
+ * the queues of busy ones.
  *
  * @param sched A pointer to the scheduler instance to initialize.
  * @param max_tasks The maximum number of tasks the scheduler can handle concurrently.
- * @return Returns 0 on successful initialization. Returns -1 if an error occurs, such as memory allocation failure.
+ * @param workers Number of worker threads, or 0 to use one per online CPU.
+ * @return Returns 0 on successful initialization. Returns -1 if an error occurs,
+ *         such as memory allocation or thread creation failure.
  */
-int sched_init(sched_t *sched, size_t max_tasks);
+int sched_pt_init(sched_t *sched, size_t max_tasks, size_t workers);
 
 /**
- * Adds a new task to the scheduler.
+ * Initializes a scheduler instance with a worker pool using the given OS
+ * scheduling attributes.
  *
- * @param sched Pointer to the scheduler instance where the task will be added.
- * @param fn Function pointer representing the task to be executed.
- * @param data Pointer to the data that will be passed to the task's function.
- * @param interval_ms Execution interval for the task in milliseconds.
- * @param priority Priority of the task, where 0 represents the lowest and 255 represents the highest.
- * @param name Name of the task for identification purposes.
- * @return Returns 0 on success, or -1 on failure (e.g., if the scheduler is null, the function pointer is null, or the task limit is reached).
+ * Real-time policies usually require CAP_SYS_NICE or a sufficient
+ * RLIMIT_RTPRIO; initialization fails instead of silently falling back to
+ * normal threads.
+ *
+ * @param sched A pointer to the scheduler instance to initialize.
+ * @param max_tasks The maximum number of tasks the scheduler can handle concurrently.
+ * @param workers Number of worker threads, or 0 to use one per online CPU.
+ * @param attr Scheduling attributes of the workers, or NULL for the defaults.
+ * @return Returns 0 on successful initialization, or -1 if an error occurs.
  */
-int sched_add_task(sched_t *sched, task_fn fn, void *data, uint32_t interval_ms, uint8_t priority, const char *name);
+int sched_pt_init_attr(sched_t *sched, size_t max_tasks, size_t workers, const sched_rt_attr_t *attr);
 
 /**
- * Starts the scheduler, managing tasks execution and priority.
+ * Selects the execution mode of the threaded scheduler.
  *
- * This function initializes the running loop for the scheduler to process
- * and execute tasks. Tasks are processed according to their priority and
- * interval timing. The function remains in a loop, continuously checking
- * for tasks to execute until an exit condition is triggered.
+ * In SCHED_PT_BARRIER mode, the default, a slow task delays every other task
+ * released in the same tick. In SCHED_PT_OVERLAP mode the dispatcher never
+ * waits for the workers: each task is released on its own drift-free grid,
+ * and a release that arrives while the task is still running is handled by
+ * the overrun policy of the task. Must be called before sched_pt_start().
  *
- * @param sched Pointer to the scheduler instance to start.
+ * @param sched Pointer to the scheduler instance, set up with sched_pt_init().
+ * @param mode The execution mode.
+ * @return Returns 0 on success, or -1 if the scheduler has no worker pool.
  */
-void sched_start(sched_t *sched);
+int sched_pt_set_mode(sched_t *sched, sched_pt_mode_t mode);
 
 /**
- * Stops the scheduler by setting its running state to false.
+ * Sets the overrun policy of the tasks added after this call.
  *
- * @param sched Pointer to the scheduler instance to be stopped.
+ * Every release handled by the policy while the task is still running counts
+ * as an overrun; releases that are dropped also count as skips.
+ *
+ * @param sched Pointer to the scheduler instance.
+ * @param policy The overrun policy, SCHED_OVERRUN_SKIP by default.
+ * @param max_instances Instance limit of SCHED_OVERRUN_CONCURRENT, between 1 and
+ *                      SCHED_PT_MAX_INSTANCES.
+ * @return Returns 0 on success, or -1 if the limit is out of range.
  */
-void sched_stop(sched_t *sched);
+int sched_pt_set_overrun(sched_t *sched, sched_overrun_t policy, unsigned max_instances);
 
 /**
- * Destroys the scheduler and releases any allocated resources.
+ * Initializes an empty task graph.
  *
- * @param sched Pointer to the scheduler instance to be destroyed.
+ * @param graph Pointer to the graph to initialize.
+ * @param max_nodes Maximum number of nodes.
+ * @return Returns 0 on success, or -1 if the allocation fails.
  */
-void sched_destroy(sched_t *sched);
+int sched_graph_init(sched_graph_t *graph, size_t max_nodes);
 
 /**
- * Sets a logging hook for the scheduler to allow tracking or debugging.
+ * Adds a node to a task graph.
  *
- * @param sched Pointer to the scheduler instance.
- * @param log_hook Function pointer to the log hook to be used for logging task-related events.
+ * @param graph Pointer to the graph.
+ * @param fn The function the node runs.
+ * @param data The user data passed to the function.
+ * @param name The name of the node.
+ * @return The index of the node, or -1 if the graph is full.
  */
-void sched_set_log_hook(sched_t *sched, sched_log_fn log_hook);
+int sched_graph_add_node(sched_graph_t *graph, task_fn fn, void *data, const char *name);
 
 /**
- * Checks if the scheduler should exit.
+ * Makes a node wait for the completion of another one.
+ *
+ * Edges must point from a node to one added after it, which keeps the graph
+ * acyclic by construction; e.g. read serial, then parse, then update state
+ * and publish over UDP.
  *
- * @return Non-zero if a shutdown request has been made, otherwise 0.
+ * @param graph Pointer to the graph.
+ * @param from Index of the upstream node.
+ * @param to Index of the downstream node, greater than from.
+ * @return Returns 0 on success, or -1 if an index is invalid or the upstream
+ *         node has SCHED_NODE_MAX_DOWNSTREAM edges already.
  */
-int sched_should_exit(void);
+int sched_graph_add_edge(sched_graph_t *graph, int from, int to);
 
 /**
- * Sets up signal handlers for the scheduler.
+ * Releases a task graph periodically on the threaded scheduler.
  *
- * Registers the signal handlers to handle termination signals
- * (e.g., SIGINT and SIGTERM). Upon receiving these signals, the
- * system sets an internal flag to indicate a shutdown request.
- * This allows the scheduler to perform graceful termination.
+ * Registers a periodic task that starts the nodes without upstream nodes.
+ * When a node completes, the worker that ran it runs the first downstream
+ * node that became ready itself, while the cache is hot, and hands the other
+ * ready nodes to idle workers, so independent branches run in parallel and
+ * the end-to-end latency is the sum of the execution times along the longest
+ * path instead of the sum of the periods. A release is skipped if the
+ * previous one is still running. In barrier mode a tick waits for the whole
+ * graph. Must be called before the scheduler starts.
+ *
+ * @param sched Pointer to the scheduler instance, initialized with sched_pt_init().
+ * @param graph Pointer to the graph, which must outlive the scheduler loop.
+ * @param interval_ms Release interval of the graph in milliseconds.
+ * @param priority Priority of the release task.
+ * @param name Name of the release task.
+ * @return Returns 0 on success, or -1 on failure.
  */
-void sched_setup_signal_handlers(void);
+int sched_pt_add_graph(sched_t *sched, sched_graph_t *graph, uint32_t interval_ms, uint8_t priority, const char *name);
 
 /**
- * Calculates the average execution time of a scheduled task in milliseconds.
+ * Releases the nodes of a task graph.
  *
- * @param task Pointer to a sched_task_t structure representing the task for which
- *             the average execution time is to be calculated.
- * @return The average execution time in milliseconds. Returns 0 if the task has
- *         not been executed at least once (run_count is 0).
+ * @param graph Pointer to the graph.
  */
-static inline uint32_t sched_avg_ms(sched_task_t *task) {
-    if (task->run_count) {
-        return task->total_duration_ms / task->run_count;
-    }
-    return 0;
-}
+void sched_graph_destroy(sched_graph_t *graph);
 
 /**
- * Calculates the average execution time of a scheduled task in microseconds.
+ * Starts the scheduler, executing due tasks on the worker pool.
+ *
+ * The scheduler instance is populated with the regular scheduler API
+ * (sched_add_task(), sched_set_log_hook(), ...); only the execution loop
+ * differs. Due tasks are pushed to the worker pool; in barrier mode the loop
+ * waits for all of them before the next tick. If the instance was set up with
+ * sched_init(), a default pool is created on the first call. The function
+ * remains in a loop until sched_stop() is called or an exit condition is
+ * triggered.
  *
- * @param task Pointer to a sched_task_t structure representing the task for which
- *             the average execution time is to be calculated.
- * @return The average execution time in microseconds. Returns 0 if the task has
- *         not been executed at least once (run_count is 0).
+ * @param sched Pointer to the scheduler instance to start.
  */
-static inline uint32_t sched_avg_us(sched_task_t *task) {
-    if (task->run_count) {
-        // You probably want to return average in microseconds here
-        return (task->total_duration_ms * 1000) / task->run_count;
-    }
-    return 0;
-}
+void sched_pt_start(sched_t *sched);
 
 /**
- * Retrieves the overrun count for a specified scheduled task.
+ * Stops the worker pool and destroys the scheduler.
  *
- * @param task Pointer to the scheduled task whose overrun count is to be fetched.
- * @return The number of times the task has overrun its deadline.
+ * @param sched Pointer to the scheduler instance to be destroyed.
  */
-static inline uint32_t sched_get_overruns(sched_task_t *task) {
-    return task->overrun_count;
-}
+void sched_pt_destroy(sched_t *sched);
 
-#endif
\ No newline at end of file
+#endif
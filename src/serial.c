@@ -2,6 +2,7 @@
 #include "serial.h"
 #include "util/net_util.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -222,7 +223,7 @@ int serial_set_blocking(serial_t *serial, int blocking) {
 
 ssize_t serial_write(serial_t *serial, const void *buf, size_t len) {
     if (!serial || serial->fd < 0 || !buf && len > 0) {
-        logger_log(LOG_LEVEL_ERROR, "serial_write");
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_write: invalid arguments");
         return -1;
     }
     if (len == 0) {
@@ -240,13 +241,21 @@ ssize_t serial_write(serial_t *serial, const void *buf, size_t len) {
             }
             continue;
         }
+        int err = errno;
+        if (err == EINTR) {
+            continue;
+        }
+        if (err != EAGAIN && err != EWOULDBLOCK) {
+            LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_write: %s", strerror(err));
+        }
+        errno = err;
         return -1;
     }
 }
 
 ssize_t serial_read(serial_t *serial, void *buf, size_t len) {
     if (!serial || serial->fd < 0 || !buf && len > 0) {
-        logger_log(LOG_LEVEL_ERROR, "serial_read");
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_read: invalid arguments");
         return -1;
     }
     if (len == 0) return 0;
@@ -255,18 +264,28 @@ ssize_t serial_read(serial_t *serial, void *buf, size_t len) {
         if (n >= 0) {
             return n;
         }
+        int err = errno;
+        if (err == EINTR) {
+            continue;
+        }
+        if (err != EAGAIN && err != EWOULDBLOCK) {
+            LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_read: %s", strerror(err));
+        }
+        errno = err;
         return -1;
     }
 }
 
 int serial_bytes_available(serial_t *serial, size_t *out_count) {
     if (!serial || serial->fd < 0) {
-        logger_log(LOG_LEVEL_ERROR, "serial_bytes_available");
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_bytes_available: invalid arguments");
         return -1;
     }
     int n = 0;
     if (ioctl(serial->fd, FIONREAD, &n) < 0) {
-        logger_log(LOG_LEVEL_ERROR, "serial_bytes_available: ioctl");
+        int err = errno;
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "serial_bytes_available: ioctl: %s", strerror(err));
+        errno = err;
         return -1;
     }
     if (n < 0) n = 0;
@@ -1,65 +1,109 @@
 #include "system.h"
 
+#include <errno.h>
+#include <pthread.h>
 #include <time.h>
+#include <sys/mman.h>
 #include <sys/types.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 static struct {
-    uint64_t start_time_ns;
+    uint64_t  start_time_ns;
+    clockid_t clock_id;
+    _Atomic uint64_t wall_offset_us;    /* Wall-clock time at micros64() == 0 */
+    atomic_int ready;                   /* Non-zero once the clock and start time are set */
 } state;
 
+static pthread_once_t clock_once = PTHREAD_ONCE_INIT;
+
 static inline uint64_t ts_to_ns(const struct timespec *ts) {
     return (uint64_t)ts->tv_sec * UINT64_C(1000000000) + (uint64_t)ts->tv_nsec;
 }
 
-static inline int get_monotonic_timespec(struct timespec *ts) {
-#if defined(CLOCK_MONOTONIC_RAW)
-    if (clock_gettime(CLOCK_MONOTONIC_RAW, ts) == 0) {
-        return 0;
-    }
-#endif
+/*
+ * CLOCK_MONOTONIC is preferred over CLOCK_MONOTONIC_RAW because it is the
+ * clock that clock_nanosleep() accepts, which lets absolute sleeps share the
+ * timeline of micros64(). The clock and the start time are set once, under
+ * pthread_once(), so that readers never race with a write.
+ */
+static int select_clock(struct timespec *ts) {
 #if defined(CLOCK_MONOTONIC)
     if (clock_gettime(CLOCK_MONOTONIC, ts) == 0) {
+        state.clock_id = CLOCK_MONOTONIC;
         return 0;
     }
 #endif
-#if defined(TIME_UTC)
-    if (timespec_get(ts, TIME_UTC) == TIME_UTC) {
+#if defined(CLOCK_MONOTONIC_RAW)
+    if (clock_gettime(CLOCK_MONOTONIC_RAW, ts) == 0) {
+        state.clock_id = CLOCK_MONOTONIC_RAW;
         return 0;
     }
 #endif
+    if (clock_gettime(CLOCK_REALTIME, ts) == 0) {
+        state.clock_id = CLOCK_REALTIME;
+        return 0;
+    }
     return -1;
 }
 
 static inline uint64_t now_ns(void) {
     struct timespec ts;
-    if (get_monotonic_timespec(&ts) != 0) {
+    if (clock_gettime(state.clock_id, &ts) != 0) {
         return 0;
     }
     return ts_to_ns(&ts);
 }
 
-void system_init(void) {
+static void init_clock(void) {
     struct timespec ts;
-    if (get_monotonic_timespec(&ts) == 0) {
+    if (select_clock(&ts) == 0) {
         state.start_time_ns = ts_to_ns(&ts);
     } else {
         state.start_time_ns = 0;
     }
+    atomic_store_explicit(&state.ready, 1, memory_order_release);
 }
 
-uint64_t micros64(void) {
-    /* Lazy initialization if system_init() was not called. */
-    if (state.start_time_ns == 0) {
-        struct timespec ts;
-        if (get_monotonic_timespec(&ts) == 0) {
-            state.start_time_ns = ts_to_ns(&ts);
-        }
+/* Lazy initialization if system_init() was not called, safe against concurrent first calls. */
+static inline void ensure_clock(void) {
+    if (!atomic_load_explicit(&state.ready, memory_order_acquire)) {
+        pthread_once(&clock_once, init_clock);
     }
+}
+
+void system_init(void) {
+    pthread_once(&clock_once, init_clock);
+    system_sync_wall_clock();
+}
+
+uint64_t micros64(void) {
+    ensure_clock();
     uint64_t start_ns = state.start_time_ns;
     uint64_t time_ns  = now_ns();
     return (time_ns - start_ns) / UINT64_C(1000);
 }
 
+void system_sync_wall_clock(void) {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME, &ts) == 0) {
+        atomic_store_explicit(&state.wall_offset_us, ts_to_ns(&ts) / UINT64_C(1000) - micros64(),
+            memory_order_relaxed);
+    }
+}
+
+uint64_t wall_micros64(void) {
+    uint64_t offset_us = atomic_load_explicit(&state.wall_offset_us, memory_order_relaxed);
+    if (offset_us == 0) {
+        system_sync_wall_clock();
+        offset_us = atomic_load_explicit(&state.wall_offset_us, memory_order_relaxed);
+    }
+    return micros64() + offset_us;
+}
+
 uint64_t millis64(void) {
     return micros64() / UINT64_C(1000);
 }
@@ -71,3 +115,69 @@ uint32_t micros(void) {
 uint32_t millis(void) {
     return (uint32_t)(millis64() & UINT64_C(0xFFFFFFFF));
 }
+
+int sleep_until_micros(uint64_t deadline_us) {
+    uint64_t now_us = micros64();
+    if (deadline_us <= now_us) {
+        return 0;
+    }
+    int rc;
+    struct timespec ts;
+#if defined(CLOCK_MONOTONIC)
+    if (state.clock_id == CLOCK_MONOTONIC) {
+        uint64_t wake_ns = state.start_time_ns + deadline_us * UINT64_C(1000);
+        ts.tv_sec  = (time_t)(wake_ns / UINT64_C(1000000000));
+        ts.tv_nsec = (long)(wake_ns % UINT64_C(1000000000));
+        while ((rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+        }
+        return rc == 0 ? 0 : -1;
+    }
+#endif
+    /* Fall back to a relative sleep on clocks clock_nanosleep() cannot use. */
+    uint64_t delta_ns = (deadline_us - now_us) * UINT64_C(1000);
+    ts.tv_sec  = (time_t)(delta_ns / UINT64_C(1000000000));
+    ts.tv_nsec = (long)(delta_ns % UINT64_C(1000000000));
+    while ((rc = nanosleep(&ts, &ts)) != 0 && errno == EINTR) {
+    }
+    return rc == 0 ? 0 : -1;
+}
+
+int wait_until_micros(uint64_t deadline_us, atomic_uint *word, unsigned expected) {
+#if defined(__linux__) && defined(FUTEX_WAIT_BITSET)
+    ensure_clock();
+    if (state.clock_id == CLOCK_MONOTONIC) {
+        uint64_t wake_ns = state.start_time_ns + deadline_us * UINT64_C(1000);
+        struct timespec ts;
+        ts.tv_sec  = (time_t)(wake_ns / UINT64_C(1000000000));
+        ts.tv_nsec = (long)(wake_ns % UINT64_C(1000000000));
+        while (atomic_load(word) == expected && micros64() < deadline_us) {
+            /* FUTEX_WAIT_BITSET takes an absolute timeout on CLOCK_MONOTONIC. */
+            long rc = syscall(SYS_futex, (unsigned *)word, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG,
+                expected, &ts, NULL, FUTEX_BITSET_MATCH_ANY);
+            if (rc != 0 && errno != EINTR && errno != EAGAIN) {
+                return errno == ETIMEDOUT ? 0 : -1;
+            }
+        }
+        return 0;
+    }
+#endif
+    (void)word;
+    (void)expected;
+    return sleep_until_micros(deadline_us);
+}
+
+void wake_waiters(atomic_uint *word) {
+#if defined(__linux__) && defined(FUTEX_WAKE)
+    (void)syscall(SYS_futex, (unsigned *)word, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT32_MAX, NULL, NULL, 0);
+#else
+    (void)word;
+#endif
+}
+
+int system_lock_memory(void) {
+#if defined(MCL_CURRENT) && defined(MCL_FUTURE)
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0 ? 0 : -1;
+#else
+    return -1;
+#endif
+}
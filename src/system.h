@@ -1,6 +1,7 @@
 #ifndef RJOS_SYSTEM_H
 #define RJOS_SYSTEM_H
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -10,7 +11,9 @@ extern "C" {
 /**
  * @brief Initializes the system state by capturing the current monotonically increasing time.
  * This function initializes the start time in nanoseconds from a monotonic clock.
- * If the clock retrieval fails, the start time is set to 0.
+ * If the clock retrieval fails, the start time is set to 0. The start time is
+ * captured once, by the first call or by the first `micros64()` if that comes
+ * earlier; later calls only measure the offset to the wall clock again.
  */
 void system_init(void);
 
@@ -24,6 +27,23 @@ void system_init(void);
  */
 uint64_t micros64(void);
 
+/**
+ * @brief Retrieves the wall-clock time in microseconds since the Unix epoch.
+ * The time is read from the clock of `micros64()` plus an offset to the wall
+ * clock, so it costs one monotonic clock read and moves smoothly, but only
+ * follows steps of the wall clock at the next `system_sync_wall_clock()`.
+ *
+ * @return The wall-clock time in microseconds.
+ */
+uint64_t wall_micros64(void);
+
+/**
+ * @brief Measures the offset between the wall clock and `micros64()` again.
+ * Called by `system_init()` and periodically by the logger, so timestamps
+ * pick up wall clock steps, e.g. by NTP after boot.
+ */
+void system_sync_wall_clock(void);
+
 /**
  * @brief Retrieves the elapsed time in microseconds since the system start.
  * This function returns the lower 32 bits of the microsecond-resolution timestamp
@@ -56,6 +76,49 @@ uint64_t millis64(void);
  */
 uint32_t millis(void);
 
+/**
+ * @brief Suspends the calling thread until the given point on the `micros64()` timeline.
+ * The wakeup time is absolute, so it does not depend on when the call was made and
+ * repeated sleeps do not accumulate drift. When the system clock is CLOCK_MONOTONIC
+ * this uses `clock_nanosleep` with TIMER_ABSTIME. Returns immediately if the deadline
+ * has already passed. Interrupted sleeps are resumed.
+ *
+ * @param deadline_us The wakeup time in microseconds since the system start.
+ * @return 0 on success, or -1 on failure.
+ */
+int sleep_until_micros(uint64_t deadline_us);
+
+/**
+ * @brief Like `sleep_until_micros`, but returns early once `*word` no longer equals `expected`.
+ * Another thread changes the word and calls `wake_waiters` to cut the sleep short. On Linux
+ * this is a futex wait with an absolute CLOCK_MONOTONIC timeout; elsewhere it degrades to
+ * a plain `sleep_until_micros`.
+ *
+ * @param deadline_us The wakeup time in microseconds since the system start.
+ * @param word The word to watch.
+ * @param expected The value of the word the caller has already seen.
+ * @return 0 on success, or -1 on failure.
+ */
+int wait_until_micros(uint64_t deadline_us, atomic_uint *word, unsigned expected);
+
+/**
+ * @brief Wakes every thread blocked in `wait_until_micros` on the given word.
+ * The caller must change the word first.
+ *
+ * @param word The word the waiters watch.
+ */
+void wake_waiters(atomic_uint *word);
+
+/**
+ * @brief Locks all current and future pages of the process in RAM.
+ * Prevents page faults from paging in code, heap or stack on latency critical
+ * paths. Usually requires CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK. Call it
+ * after the large allocations are made, so that they are faulted in once.
+ *
+ * @return 0 on success, or -1 on failure or if memory locking is not supported.
+ */
+int system_lock_memory(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,7 @@
 #include "util/net_util.h"
 
 #include <arpa/inet.h>
+#include <errno.h>
 #include <netdb.h>
 #include <stdlib.h>
 #include <string.h>
@@ -68,7 +69,7 @@ int udp_init(udp_t *udp, const char *host, uint16_t port) {
 
 int udp_send(udp_t *udp, char *data, size_t len) {
     if (!udp || udp->sockfd < 0 || (!data && len > 0)) {
-        logger_log(LOG_LEVEL_ERROR, "udp_send: invalid arguments");
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "udp_send: invalid arguments");
         return -1;
     }
     if (len == 0) {
@@ -82,12 +83,20 @@ int udp_send(udp_t *udp, char *data, size_t len) {
             }
             return n;
         }
+        int err = errno;
+        if (err != EINTR) {
+            if (err != EAGAIN && err != EWOULDBLOCK) {
+                LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "udp_send: %s", strerror(err));
+            }
+            errno = err;
+            return -1;
+        }
     }
 }
 
 int udp_recv(udp_t *udp, char *data, size_t len) {
     if (!udp || udp->sockfd < 0 || (!data && len > 0)) {
-        logger_log(LOG_LEVEL_ERROR, "udp_recv: invalid arguments");
+        LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "udp_recv: invalid arguments");
         return -1;
     }
     if (len == 0) {
@@ -101,6 +110,14 @@ int udp_recv(udp_t *udp, char *data, size_t len) {
             }
             return n;
         }
+        int err = errno;
+        if (err != EINTR) {
+            if (err != EAGAIN && err != EWOULDBLOCK) {
+                LOG_RATELIMITED(LOG_LEVEL_ERROR, LOGGER_RATE, LOGGER_BURST, "udp_recv: %s", strerror(err));
+            }
+            errno = err;
+            return -1;
+        }
     }
 }
 
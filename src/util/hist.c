@@ -0,0 +1,56 @@
+#include "hist.h"
+
+#include <string.h>
+
+static inline uint32_t bucket_of(uint64_t value) {
+    if (value > HIST_MAX_VALUE) {
+        value = HIST_MAX_VALUE;
+    }
+    if (value < HIST_SUB_COUNT) {
+        return (uint32_t)value;
+    }
+    uint32_t msb   = 63u - (uint32_t)__builtin_clzll(value);
+    uint32_t shift = msb - HIST_SUB_BITS;
+    return (shift + 1) * HIST_SUB_COUNT + (uint32_t)((value >> shift) & (HIST_SUB_COUNT - 1));
+}
+
+static inline uint64_t bucket_upper(uint32_t bucket) {
+    if (bucket < HIST_SUB_COUNT) {
+        return bucket;
+    }
+    uint32_t shift = bucket / HIST_SUB_COUNT - 1;
+    uint64_t low   = (uint64_t)(HIST_SUB_COUNT + bucket % HIST_SUB_COUNT) << shift;
+    return low + (UINT64_C(1) << shift) - 1;
+}
+
+void hist_reset(hist_t *hist) {
+    memset(hist, 0, sizeof(*hist));
+}
+
+void hist_record(hist_t *hist, uint64_t value) {
+    hist->counts[bucket_of(value)]++;
+    hist->total++;
+    if (value > hist->max) {
+        hist->max = value;
+    }
+}
+
+uint64_t hist_percentile(const hist_t *hist, double percentile) {
+    if (hist->total == 0) {
+        return 0;
+    }
+    /* Rank of the requested value, rounded up and at least 1. */
+    uint64_t rank = (uint64_t)((percentile / 100.0) * (double)hist->total + 0.999999);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += hist->counts[i];
+        if (seen >= rank) {
+            uint64_t upper = bucket_upper(i);
+            return upper < hist->max ? upper : hist->max;
+        }
+    }
+    return hist->max;
+}
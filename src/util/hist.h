@@ -0,0 +1,52 @@
+#ifndef HIST_H
+#define HIST_H
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS   3
+#define HIST_MAX_BITS   26
+#define HIST_SUB_COUNT  (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS    ((HIST_MAX_BITS - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+#define HIST_MAX_VALUE  ((UINT64_C(1) << HIST_MAX_BITS) - 1)
+
+/**
+ * @brief Log-linear histogram in the style of HdrHistogram.
+ * @details Values below HIST_SUB_COUNT get one bucket each. Every power of two
+ * above that is split into HIST_SUB_COUNT linear sub-buckets, which bounds the
+ * relative error of a reported percentile to 1 / HIST_SUB_COUNT. Values above
+ * HIST_MAX_VALUE (about 67 s when recording microseconds) are clamped into the
+ * last bucket, but the exact maximum is always kept.
+ */
+typedef struct hist {
+    uint32_t counts[HIST_BUCKETS];
+    uint64_t total;     /**< Number of recorded values */
+    uint64_t max;       /**< Largest recorded value */
+} hist_t;
+
+/**
+ * @brief Clears all recorded values.
+ *
+ * @param hist Pointer to the histogram.
+ */
+void hist_reset(hist_t *hist);
+
+/**
+ * @brief Records a single value in O(1).
+ *
+ * @param hist Pointer to the histogram.
+ * @param value The value to record.
+ */
+void hist_record(hist_t *hist, uint64_t value);
+
+/**
+ * @brief Computes the value at the given percentile.
+ * @details The upper bound of the bucket holding the percentile is returned,
+ * capped at the recorded maximum.
+ *
+ * @param hist Pointer to the histogram.
+ * @param percentile Percentile in the range [0, 100].
+ * @return The value at the percentile, or 0 if nothing was recorded.
+ */
+uint64_t hist_percentile(const hist_t *hist, double percentile);
+
+#endif
@@ -0,0 +1,294 @@
+#include "log_format.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Longest string argument rendered back by log_format_render(). */
+#define LOG_FORMAT_MAX_STR 1024
+
+/**
+ * @brief Parses the conversion following a '%'.
+ *
+ * @param p First character after the '%'.
+ * @param length Receives the length modifier: 'H' for hh, 'q' for ll, the
+ *        modifier character otherwise, or 0.
+ * @param conv Receives the conversion character.
+ * @return Pointer past the conversion, or NULL if it takes a '*' argument or
+ *         the format ends early.
+ */
+static const char *parse_spec(const char *p, char *length, char *conv) {
+    while (*p && strchr("-+ #0'", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        return NULL;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            return NULL;
+        }
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    *length = 0;
+    if (p[0] == 'h' && p[1] == 'h') {
+        *length = 'H';
+        p += 2;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        *length = 'q';
+        p += 2;
+    } else if (*p && strchr("hlLjzt", *p)) {
+        *length = *p++;
+    }
+    if (!*p) {
+        return NULL;
+    }
+    *conv = *p++;
+    return p;
+}
+
+/**
+ * @brief Maps a conversion to the type of its argument, or -1 if unsupported.
+ */
+static int arg_type(char length, char conv) {
+    switch (conv) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            switch (length) {
+                case 'l': return LOG_ARG_LONG;
+                case 'q': return LOG_ARG_LLONG;
+                case 'z': return LOG_ARG_SIZE;
+                case 'j': return LOG_ARG_INTMAX;
+                case 't': return LOG_ARG_PTRDIFF;
+                case 'L': return -1;
+                default:  return LOG_ARG_INT;
+            }
+        case 'c':
+            return length == 'l' ? -1 : LOG_ARG_INT;
+        case 's':
+            return length == 'l' ? -1 : LOG_ARG_STR;
+        case 'p':
+            return LOG_ARG_PTR;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            return length == 'L' ? LOG_ARG_LDOUBLE : LOG_ARG_DOUBLE;
+        default:
+            return -1;
+    }
+}
+
+/**
+ * @brief Returns the stored size of an argument, 2 for the length of a string.
+ */
+static size_t arg_size(int type) {
+    switch (type) {
+        case LOG_ARG_INT: return sizeof(int);
+        case LOG_ARG_STR: return sizeof(uint16_t);
+        default:          return sizeof(uint64_t);
+    }
+}
+
+int log_format_parse(const char *format, uint8_t *types, size_t max) {
+    size_t count = 0;
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        if (p[1] == '%') {
+            p++;
+            continue;
+        }
+        char length;
+        char conv;
+        const char *end = parse_spec(p + 1, &length, &conv);
+        int type = end ? arg_type(length, conv) : -1;
+        if (type < 0 || count >= max) {
+            return -1;
+        }
+        types[count++] = (uint8_t)type;
+        p = end - 1;
+    }
+    return (int)count;
+}
+
+size_t log_format_pack(uint8_t *out, size_t size, const uint8_t *types, size_t count, va_list args) {
+    size_t len = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t value = 0;
+        switch (types[i]) {
+            case LOG_ARG_INT: {
+                int v = va_arg(args, int);
+                if (len + sizeof(v) > size) {
+                    return len;
+                }
+                memcpy(out + len, &v, sizeof(v));
+                len += sizeof(v);
+                continue;
+            }
+            case LOG_ARG_STR: {
+                const char *s = va_arg(args, const char *);
+                if (!s) {
+                    s = "(null)";
+                }
+                /* Leave room for the arguments after the string. */
+                size_t reserve = sizeof(uint16_t);
+                for (size_t j = i + 1; j < count; j++) {
+                    reserve += arg_size(types[j]);
+                }
+                size_t room = size > len + reserve ? size - len - reserve : 0;
+                if (room > UINT16_MAX) {
+                    room = UINT16_MAX;
+                }
+                if (len + sizeof(uint16_t) > size) {
+                    return len;
+                }
+                uint16_t n = (uint16_t)strnlen(s, room);
+                memcpy(out + len, &n, sizeof(n));
+                memcpy(out + len + sizeof(n), s, n);
+                len += sizeof(n) + n;
+                continue;
+            }
+            case LOG_ARG_LONG:
+                value = (uint64_t)va_arg(args, long);
+                break;
+            case LOG_ARG_LLONG:
+                value = (uint64_t)va_arg(args, long long);
+                break;
+            case LOG_ARG_SIZE:
+                value = (uint64_t)va_arg(args, size_t);
+                break;
+            case LOG_ARG_INTMAX:
+                value = (uint64_t)va_arg(args, intmax_t);
+                break;
+            case LOG_ARG_PTRDIFF:
+                value = (uint64_t)va_arg(args, ptrdiff_t);
+                break;
+            case LOG_ARG_PTR:
+                value = (uint64_t)(uintptr_t)va_arg(args, void *);
+                break;
+            case LOG_ARG_DOUBLE:
+            case LOG_ARG_LDOUBLE: {
+                double d = types[i] == LOG_ARG_DOUBLE ? va_arg(args, double) : (double)va_arg(args, long double);
+                memcpy(&value, &d, sizeof(d));
+                break;
+            }
+            default:
+                return len;
+        }
+        if (len + sizeof(value) > size) {
+            return len;
+        }
+        memcpy(out + len, &value, sizeof(value));
+        len += sizeof(value);
+    }
+    return len;
+}
+
+int log_format_render(char *out, size_t size, const char *format, const uint8_t *payload, size_t len) {
+    size_t pos = 0;
+    size_t off = 0;
+    int rc = 0;
+    const char *p = format;
+    if (size == 0) {
+        return -1;
+    }
+    while (*p && pos + 1 < size) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p += 2;
+            continue;
+        }
+        char length;
+        char conv;
+        const char *end = parse_spec(p + 1, &length, &conv);
+        int type = end ? arg_type(length, conv) : -1;
+        char spec[32];
+        size_t spec_len = end ? (size_t)(end - p) : 0;
+        if (type < 0 || spec_len >= sizeof(spec) || off + arg_size(type) > len) {
+            rc = -1;
+            break;
+        }
+        memcpy(spec, p, spec_len);
+        spec[spec_len] = '\0';
+
+        int is_unsigned = strchr("uoxX", conv) != NULL;
+        char *dst = out + pos;
+        size_t room = size - pos;
+        uint64_t value = 0;
+        int n;
+        if (type != LOG_ARG_INT && type != LOG_ARG_STR) {
+            memcpy(&value, payload + off, sizeof(value));
+        }
+        switch (type) {
+            case LOG_ARG_INT: {
+                int v;
+                memcpy(&v, payload + off, sizeof(v));
+                n = snprintf(dst, room, spec, v);
+                break;
+            }
+            case LOG_ARG_STR: {
+                uint16_t str_len;
+                memcpy(&str_len, payload + off, sizeof(str_len));
+                if (off + sizeof(str_len) + str_len > len) {
+                    rc = -1;
+                    break;
+                }
+                char str[LOG_FORMAT_MAX_STR];
+                size_t copy = str_len < sizeof(str) ? str_len : sizeof(str) - 1;
+                memcpy(str, payload + off + sizeof(str_len), copy);
+                str[copy] = '\0';
+                off += str_len;
+                n = snprintf(dst, room, spec, str);
+                break;
+            }
+            case LOG_ARG_LONG:
+                n = is_unsigned ? snprintf(dst, room, spec, (unsigned long)value) : snprintf(dst, room, spec, (long)value);
+                break;
+            case LOG_ARG_LLONG:
+                n = is_unsigned ? snprintf(dst, room, spec, (unsigned long long)value)
+                                : snprintf(dst, room, spec, (long long)value);
+                break;
+            case LOG_ARG_SIZE:
+                n = is_unsigned ? snprintf(dst, room, spec, (size_t)value) : snprintf(dst, room, spec, (ptrdiff_t)value);
+                break;
+            case LOG_ARG_INTMAX:
+                n = is_unsigned ? snprintf(dst, room, spec, (uintmax_t)value) : snprintf(dst, room, spec, (intmax_t)value);
+                break;
+            case LOG_ARG_PTRDIFF:
+                n = is_unsigned ? snprintf(dst, room, spec, (size_t)value) : snprintf(dst, room, spec, (ptrdiff_t)value);
+                break;
+            case LOG_ARG_PTR:
+                n = snprintf(dst, room, spec, (void *)(uintptr_t)value);
+                break;
+            default: {
+                double d;
+                memcpy(&d, &value, sizeof(d));
+                if (type == LOG_ARG_LDOUBLE) {
+                    /* The value was narrowed to double, drop the L modifier. */
+                    spec[spec_len - 2] = conv;
+                    spec[spec_len - 1] = '\0';
+                }
+                n = snprintf(dst, room, spec, d);
+                break;
+            }
+        }
+        if (rc != 0) {
+            break;
+        }
+        off += arg_size(type);
+        if (n > 0) {
+            pos += (size_t)n < room ? (size_t)n : room - 1;
+        }
+        p = end;
+    }
+    out[pos] = '\0';
+    return rc;
+}
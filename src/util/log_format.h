@@ -0,0 +1,69 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum number of conversions of a binary log format. */
+#define LOG_FORMAT_MAX_ARGS 16
+
+/**
+ * @brief How an argument of a printf conversion is passed and stored.
+ * @details Integers narrower than int travel as int; every wider integer,
+ * pointer and floating-point value is stored in 8 bytes, long double
+ * narrowed to double. Strings are stored as a 16-bit length and the bytes.
+ */
+typedef enum log_arg {
+    LOG_ARG_INT,
+    LOG_ARG_LONG,
+    LOG_ARG_LLONG,
+    LOG_ARG_SIZE,
+    LOG_ARG_INTMAX,
+    LOG_ARG_PTRDIFF,
+    LOG_ARG_DOUBLE,
+    LOG_ARG_LDOUBLE,
+    LOG_ARG_PTR,
+    LOG_ARG_STR,
+} log_arg_t;
+
+/**
+ * @brief Lists the argument types of a printf format string.
+ * @details Conversions whose arguments cannot be captured as values, such
+ * as '*' widths, %n and wide strings, are rejected so that the caller can
+ * format the message as text instead.
+ *
+ * @param format The format string.
+ * @param types Receives one log_arg_t per conversion.
+ * @param max Capacity of types.
+ * @return Number of conversions, or -1 if the format is not supported.
+ */
+int log_format_parse(const char *format, uint8_t *types, size_t max);
+
+/**
+ * @brief Copies the arguments of a message into a binary payload.
+ * @details Strings are truncated so that the arguments after them still fit.
+ *
+ * @param out Buffer receiving the payload.
+ * @param size Capacity of the buffer.
+ * @param types Argument types returned by log_format_parse().
+ * @param count Number of arguments.
+ * @param args The arguments.
+ * @return Length of the payload.
+ */
+size_t log_format_pack(uint8_t *out, size_t size, const uint8_t *types, size_t count, va_list args);
+
+/**
+ * @brief Formats a message from its format string and binary payload.
+ *
+ * @param out Buffer receiving the NUL-terminated message, truncated if needed.
+ * @param size Capacity of the buffer.
+ * @param format The format string the payload was packed for.
+ * @param payload The payload returned by log_format_pack().
+ * @param len Length of the payload.
+ * @return Returns 0 on success, or -1 if the payload is shorter than the
+ *         format requires, in which case the message is cut there.
+ */
+int log_format_render(char *out, size_t size, const char *format, const uint8_t *payload, size_t len);
+
+#endif
@@ -0,0 +1,73 @@
+#include "log_ring.h"
+
+#include <stdlib.h>
+
+int log_ring_init(log_ring_t *ring, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    ring->cells = malloc(size * sizeof(log_ring_cell_t));
+    if (!ring->cells) {
+        return -1;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&ring->cells[i].seq, i);
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->tail, 0);
+    ring->head = 0;
+    return 0;
+}
+
+char *log_ring_claim(log_ring_t *ring, size_t *pos) {
+    size_t p = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        log_ring_cell_t *cell = &ring->cells[p & ring->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)p;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &p, p + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                *pos = p;
+                return cell->data;
+            }
+        } else if (diff < 0) {
+            /* The consumer has not released this cell yet. */
+            return NULL;
+        } else {
+            p = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+}
+
+void log_ring_publish(log_ring_t *ring, size_t pos, size_t len) {
+    log_ring_cell_t *cell = &ring->cells[pos & ring->mask];
+    cell->len = (uint32_t)(len < LOG_RING_RECORD_SIZE ? len : LOG_RING_RECORD_SIZE);
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+}
+
+const char *log_ring_peek(log_ring_t *ring, size_t offset, size_t *len) {
+    size_t pos = ring->head + offset;
+    log_ring_cell_t *cell = &ring->cells[pos & ring->mask];
+    if (offset > ring->mask || atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) {
+        return NULL;
+    }
+    *len = cell->len;
+    return cell->data;
+}
+
+void log_ring_release(log_ring_t *ring, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        size_t pos = ring->head + i;
+        /* Hand the cell back to the producers for the next lap. */
+        atomic_store_explicit(&ring->cells[pos & ring->mask].seq, pos + ring->mask + 1, memory_order_release);
+    }
+    ring->head += count;
+}
+
+void log_ring_destroy(log_ring_t *ring) {
+    free(ring->cells);
+    ring->cells = NULL;
+    ring->mask = 0;
+}
@@ -0,0 +1,85 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Capacity of a record, longer records are truncated by the caller. */
+#define LOG_RING_RECORD_SIZE 256
+
+/**
+ * @brief A cell of the log ring, holding one record.
+ */
+typedef struct log_ring_cell {
+    atomic_size_t seq;
+    uint32_t      len;
+    char          data[LOG_RING_RECORD_SIZE];
+} log_ring_cell_t;
+
+/**
+ * @brief Bounded lock-free multi-producer, single-consumer ring of log records.
+ * @details The same sequence-numbered cells as the scheduler submission queue,
+ * except that producers fill a claimed cell in place and publish it when
+ * done, and the consumer reads a batch of published cells in place before
+ * handing them back, so a record is never copied between the caller and the
+ * write.
+ */
+typedef struct log_ring {
+    log_ring_cell_t *cells;
+    size_t           mask;
+    _Alignas(64) atomic_size_t tail;   /**< Next cell to claim, shared by the producers */
+    _Alignas(64) size_t        head;   /**< Oldest cell not yet released, owned by the consumer */
+} log_ring_t;
+
+/**
+ * @brief Allocates a ring holding at least capacity records.
+ *
+ * @param ring Pointer to the ring to initialize.
+ * @param capacity Minimum number of records, rounded up to a power of two.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int log_ring_init(log_ring_t *ring, size_t capacity);
+
+/**
+ * @brief Claims the next free cell. Safe to call from any thread.
+ *
+ * @param ring Pointer to the ring.
+ * @param pos Receives the position to pass to log_ring_publish().
+ * @return Pointer to LOG_RING_RECORD_SIZE bytes to fill, or NULL if the ring is full.
+ */
+char *log_ring_claim(log_ring_t *ring, size_t *pos);
+
+/**
+ * @brief Publishes a claimed cell to the consumer.
+ *
+ * @param ring Pointer to the ring.
+ * @param pos Position returned by log_ring_claim().
+ * @param len Number of bytes filled, at most LOG_RING_RECORD_SIZE.
+ */
+void log_ring_publish(log_ring_t *ring, size_t pos, size_t len);
+
+/**
+ * @brief Returns a published record without releasing it. Consumer only.
+ *
+ * @param ring Pointer to the ring.
+ * @param offset Offset of the record from the oldest unreleased one.
+ * @param len Receives the length of the record.
+ * @return Pointer to the record, or NULL if it is not published yet.
+ */
+const char *log_ring_peek(log_ring_t *ring, size_t offset, size_t *len);
+
+/**
+ * @brief Hands the oldest records back to the producers. Consumer only.
+ *
+ * @param ring Pointer to the ring.
+ * @param count Number of records, all previously returned by log_ring_peek().
+ */
+void log_ring_release(log_ring_t *ring, size_t count);
+
+/**
+ * @brief Frees the cells of a ring.
+ */
+void log_ring_destroy(log_ring_t *ring);
+
+#endif
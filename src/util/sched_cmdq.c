@@ -0,0 +1,64 @@
+#include "sched_cmdq.h"
+
+#include <stdlib.h>
+
+int sched_cmdq_init(sched_cmdq_t *queue, size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    queue->cells = malloc(size * sizeof(sched_cmdq_cell_t));
+    if (!queue->cells) {
+        return -1;
+    }
+    for (size_t i = 0; i < size; i++) {
+        atomic_init(&queue->cells[i].seq, i);
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->tail, 0);
+    queue->head = 0;
+    return 0;
+}
+
+int sched_cmdq_push(sched_cmdq_t *queue, const sched_cmd_t *cmd) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    for (;;) {
+        sched_cmdq_cell_t *cell = &queue->cells[pos & queue->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            /* The cell is free for this lap: claim it. */
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                cell->cmd = *cmd;
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            /* The consumer has not drained this cell yet. */
+            return -1;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+int sched_cmdq_pop(sched_cmdq_t *queue, sched_cmd_t *cmd) {
+    size_t pos = queue->head;
+    sched_cmdq_cell_t *cell = &queue->cells[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    if (seq != pos + 1) {
+        return -1;
+    }
+    *cmd = cell->cmd;
+    /* Hand the cell back to the producers for the next lap. */
+    atomic_store_explicit(&cell->seq, pos + queue->mask + 1, memory_order_release);
+    queue->head = pos + 1;
+    return 0;
+}
+
+void sched_cmdq_destroy(sched_cmdq_t *queue) {
+    free(queue->cells);
+    queue->cells = NULL;
+    queue->mask = 0;
+}
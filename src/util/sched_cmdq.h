@@ -0,0 +1,95 @@
+#ifndef SCHED_CMDQ_H
+#define SCHED_CMDQ_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Capacity of a task name, including the terminating NUL. */
+#define SCHED_CMD_NAME_LEN 32
+
+/**
+ * @brief Kinds of requests submitted to a running scheduler.
+ */
+typedef enum sched_cmd_type {
+    SCHED_CMD_ADD,
+    SCHED_CMD_CANCEL,
+    SCHED_CMD_PAUSE,
+    SCHED_CMD_RESUME,
+    SCHED_CMD_RETIME,
+} sched_cmd_type_t;
+
+/**
+ * @brief A request submitted to a running scheduler.
+ */
+typedef struct sched_cmd {
+    sched_cmd_type_t type;
+    size_t           idx;           /**< Task slot the request applies to */
+    uint32_t         gen;           /**< Generation of the slot, stale requests are dropped */
+    uint32_t         interval_ms;   /**< New interval for SCHED_CMD_ADD and SCHED_CMD_RETIME */
+    uint32_t         delay_ms;      /**< Delay before the first release for SCHED_CMD_ADD */
+    uint8_t          priority;
+    uint8_t          oneshot;       /**< Non-zero if the added task runs once */
+    void           (*fn)(void *);
+    void            *data;
+    void            *hist;          /**< Histograms allocated by the submitter, or NULL */
+    char             name[SCHED_CMD_NAME_LEN];
+} sched_cmd_t;
+
+/**
+ * @brief A cell of the submission queue.
+ */
+typedef struct sched_cmdq_cell {
+    atomic_size_t seq;
+    sched_cmd_t   cmd;
+} sched_cmdq_cell_t;
+
+/**
+ * @brief Bounded lock-free multi-producer, single-consumer request queue.
+ * @details Each cell carries a sequence number telling producers whether it
+ * is free and the consumer whether it is filled (Vyukov's bounded queue), so
+ * neither side ever takes a lock. The producer and consumer cursors live on
+ * separate cache lines.
+ */
+typedef struct sched_cmdq {
+    sched_cmdq_cell_t *cells;
+    size_t             mask;
+    _Alignas(64) atomic_size_t tail;   /**< Next cell to fill, shared by the producers */
+    _Alignas(64) size_t        head;   /**< Next cell to drain, owned by the consumer */
+} sched_cmdq_t;
+
+/**
+ * @brief Allocates a queue holding at least capacity requests.
+ *
+ * @param queue Pointer to the queue to initialize.
+ * @param capacity Minimum number of requests, rounded up to a power of two.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int sched_cmdq_init(sched_cmdq_t *queue, size_t capacity);
+
+/**
+ * @brief Appends a request. Safe from any thread.
+ *
+ * @param queue Pointer to the queue.
+ * @param cmd The request to append.
+ * @return Returns 0 on success, or -1 if the queue is full.
+ */
+int sched_cmdq_push(sched_cmdq_t *queue, const sched_cmd_t *cmd);
+
+/**
+ * @brief Removes the oldest request. Consumer only.
+ *
+ * @param queue Pointer to the queue.
+ * @param cmd Receives the request.
+ * @return Returns 0 on success, or -1 if the queue is empty.
+ */
+int sched_cmdq_pop(sched_cmdq_t *queue, sched_cmd_t *cmd);
+
+/**
+ * @brief Releases the storage owned by the queue.
+ *
+ * @param queue Pointer to the queue.
+ */
+void sched_cmdq_destroy(sched_cmdq_t *queue);
+
+#endif
@@ -0,0 +1,148 @@
+#include "sched_heap.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * @brief Orders two heap entries.
+ *
+ * @return Non-zero if a must be dispatched before b.
+ */
+static inline int entry_before(const sched_heap_entry_t *a, const sched_heap_entry_t *b) {
+    if (a->due_us != b->due_us) {
+        return a->due_us < b->due_us;
+    }
+    return a->priority > b->priority;
+}
+
+/**
+ * @brief Stores an entry at a heap position and records the position.
+ */
+static inline void place(sched_heap_t *heap, size_t i, sched_heap_entry_t entry) {
+    heap->entries[i] = entry;
+    heap->pos[entry.idx] = i;
+}
+
+/**
+ * @brief Moves an entry up from position i until its parent precedes it.
+ */
+static void sift_up(sched_heap_t *heap, size_t i, sched_heap_entry_t entry) {
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!entry_before(&entry, &heap->entries[parent])) {
+            break;
+        }
+        place(heap, i, heap->entries[parent]);
+        i = parent;
+    }
+    place(heap, i, entry);
+}
+
+/**
+ * @brief Moves an entry down from position i until it precedes its children.
+ */
+static void sift_down(sched_heap_t *heap, size_t i, sched_heap_entry_t entry) {
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && entry_before(&heap->entries[child + 1], &heap->entries[child])) {
+            child++;
+        }
+        if (!entry_before(&heap->entries[child], &entry)) {
+            break;
+        }
+        place(heap, i, heap->entries[child]);
+        i = child;
+    }
+    place(heap, i, entry);
+}
+
+int sched_heap_init(sched_heap_t *heap, size_t capacity) {
+    heap->entries = calloc(capacity ? capacity : 1, sizeof(sched_heap_entry_t));
+    heap->pos     = malloc((capacity ? capacity : 1) * sizeof(size_t));
+    if (!heap->entries || !heap->pos) {
+        free(heap->entries);
+        free(heap->pos);
+        heap->entries = NULL;
+        heap->pos     = NULL;
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        heap->pos[i] = SCHED_HEAP_NPOS;
+    }
+    heap->count    = 0;
+    heap->capacity = capacity;
+    return 0;
+}
+
+int sched_heap_push(sched_heap_t *heap, sched_heap_entry_t entry) {
+    if (entry.idx >= heap->capacity) {
+        return -1;
+    }
+    size_t i = heap->pos[entry.idx];
+    if (i != SCHED_HEAP_NPOS) {
+        /* Already queued: move the entry to its new place. */
+        if (entry_before(&entry, &heap->entries[i])) {
+            sift_up(heap, i, entry);
+        } else {
+            sift_down(heap, i, entry);
+        }
+        return 0;
+    }
+    if (heap->count >= heap->capacity) {
+        return -1;
+    }
+    sift_up(heap, heap->count++, entry);
+    return 0;
+}
+
+int sched_heap_pop(sched_heap_t *heap, sched_heap_entry_t *out) {
+    if (heap->count == 0) {
+        return -1;
+    }
+    *out = heap->entries[0];
+    heap->pos[out->idx] = SCHED_HEAP_NPOS;
+
+    /* Sift down the last entry from the root. */
+    sched_heap_entry_t last = heap->entries[--heap->count];
+    if (heap->count > 0) {
+        sift_down(heap, 0, last);
+    }
+    return 0;
+}
+
+int sched_heap_remove(sched_heap_t *heap, size_t idx) {
+    if (idx >= heap->capacity || heap->pos[idx] == SCHED_HEAP_NPOS) {
+        return -1;
+    }
+    size_t i = heap->pos[idx];
+    heap->pos[idx] = SCHED_HEAP_NPOS;
+    sched_heap_entry_t last = heap->entries[--heap->count];
+    if (i < heap->count) {
+        /* Refill the hole with the last entry, which may need to move either way. */
+        if (i > 0 && entry_before(&last, &heap->entries[(i - 1) / 2])) {
+            sift_up(heap, i, last);
+        } else {
+            sift_down(heap, i, last);
+        }
+    }
+    return 0;
+}
+
+void sched_heap_clear(sched_heap_t *heap) {
+    for (size_t i = 0; i < heap->count; i++) {
+        heap->pos[heap->entries[i].idx] = SCHED_HEAP_NPOS;
+    }
+    heap->count = 0;
+}
+
+void sched_heap_destroy(sched_heap_t *heap) {
+    free(heap->entries);
+    free(heap->pos);
+    heap->entries  = NULL;
+    heap->pos      = NULL;
+    heap->count    = 0;
+    heap->capacity = 0;
+}
@@ -0,0 +1,95 @@
+#ifndef SCHED_HEAP_H
+#define SCHED_HEAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief A single entry of the scheduler run queue.
+ * @details The release time and priority are copied into the entry so that
+ * sift operations never have to dereference the task table.
+ */
+typedef struct sched_heap_entry {
+    uint64_t due_us;    /**< Release time of the task, as returned by micros64() */
+    uint8_t  priority;  /**< Tiebreak for equal due times, higher first */
+    size_t   idx;       /**< Index of the task in the scheduler task table */
+} sched_heap_entry_t;
+
+/** Position of a task index that is not in the heap. */
+#define SCHED_HEAP_NPOS ((size_t)-1)
+
+/**
+ * @brief Binary min-heap ordered by due time, then by descending priority.
+ * @details Each task index appears at most once. Its position is tracked so
+ * that an entry can be removed or re-keyed in O(log n).
+ */
+typedef struct sched_heap {
+    sched_heap_entry_t *entries;
+    size_t             *pos;        /**< Heap position of each task index, or SCHED_HEAP_NPOS */
+    size_t              count;
+    size_t              capacity;
+} sched_heap_t;
+
+/**
+ * @brief Allocates storage for a heap holding up to capacity entries.
+ *
+ * @param heap Pointer to the heap to initialize.
+ * @param capacity Maximum number of entries the heap can hold, and the bound of
+ *                 the task indices.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int sched_heap_init(sched_heap_t *heap, size_t capacity);
+
+/**
+ * @brief Inserts an entry into the heap in O(log n).
+ * @details If the task index is already queued, its entry is replaced.
+ *
+ * @param heap Pointer to the heap.
+ * @param entry Entry to insert.
+ * @return Returns 0 on success, or -1 if the heap is full or the index is out of range.
+ */
+int sched_heap_push(sched_heap_t *heap, sched_heap_entry_t entry);
+
+/**
+ * @brief Removes the earliest due entry from the heap in O(log n).
+ *
+ * @param heap Pointer to the heap.
+ * @param out Receives the removed entry.
+ * @return Returns 0 on success, or -1 if the heap is empty.
+ */
+int sched_heap_pop(sched_heap_t *heap, sched_heap_entry_t *out);
+
+/**
+ * @brief Removes the entry of a task index in O(log n).
+ *
+ * @param heap Pointer to the heap.
+ * @param idx Task index to remove.
+ * @return Returns 0 on success, or -1 if the index is not queued.
+ */
+int sched_heap_remove(sched_heap_t *heap, size_t idx);
+
+/**
+ * @brief Removes all entries.
+ *
+ * @param heap Pointer to the heap.
+ */
+void sched_heap_clear(sched_heap_t *heap);
+
+/**
+ * @brief Returns the earliest due entry without removing it.
+ *
+ * @param heap Pointer to the heap.
+ * @return Pointer to the top entry, or NULL if the heap is empty.
+ */
+static inline const sched_heap_entry_t *sched_heap_peek(const sched_heap_t *heap) {
+    return heap->count ? &heap->entries[0] : NULL;
+}
+
+/**
+ * @brief Releases the storage owned by the heap.
+ *
+ * @param heap Pointer to the heap.
+ */
+void sched_heap_destroy(sched_heap_t *heap);
+
+#endif
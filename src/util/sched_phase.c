@@ -0,0 +1,94 @@
+#include "sched_phase.h"
+
+#include <stdlib.h>
+
+static uint64_t gcd64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+int sched_phase_assign(const sched_phase_task_t *tasks, size_t count, uint32_t *offsets) {
+    uint64_t hyper_ms = 1;
+    uint32_t max_interval = 1;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t interval = tasks[i].interval_ms;
+        if (interval == 0) {
+            return -1;
+        }
+        hyper_ms = hyper_ms / gcd64(hyper_ms, interval) * interval;
+        if (hyper_ms > SCHED_PHASE_MAX_HYPERPERIOD_MS) {
+            return -1;
+        }
+        if (tasks[i].interval_ms > max_interval) {
+            max_interval = tasks[i].interval_ms;
+        }
+    }
+
+    uint64_t res_ms = 1;
+    while (hyper_ms / res_ms > SCHED_PHASE_MAX_SLOTS) {
+        res_ms <<= 1;
+    }
+    size_t slots = (size_t)((hyper_ms + res_ms - 1) / res_ms);
+    uint64_t *load = calloc(slots, sizeof(uint64_t));
+    uint64_t *cost = malloc(((max_interval + res_ms - 1) / res_ms) * sizeof(uint64_t));
+    if (!load || !cost) {
+        free(load);
+        free(cost);
+        return -1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t interval = tasks[i].interval_ms;
+        uint64_t weight = tasks[i].wcet_us ? tasks[i].wcet_us : 1;
+        size_t candidates = (size_t)((interval + res_ms - 1) / res_ms);
+        uint64_t releases = hyper_ms / interval;
+
+        /* Peak load each candidate offset would add to. */
+        uint64_t best = UINT64_MAX;
+        for (size_t c = 0; c < candidates; c++) {
+            uint64_t peak = 0;
+            for (uint64_t k = 0; k < releases; k++) {
+                uint64_t slot_load = load[((c * res_ms + k * interval) / res_ms) % slots];
+                if (slot_load > peak) {
+                    peak = slot_load;
+                }
+            }
+            cost[c] = peak;
+            if (peak < best) {
+                best = peak;
+            }
+        }
+
+        /* Take the middle of the longest run of best offsets. */
+        size_t run_start = 0;
+        size_t run_len = 0;
+        for (size_t c = 0; c < candidates;) {
+            if (cost[c] != best) {
+                c++;
+                continue;
+            }
+            size_t start = c;
+            while (c < candidates && cost[c] == best) {
+                c++;
+            }
+            if (c - start > run_len) {
+                run_start = start;
+                run_len = c - start;
+            }
+        }
+        size_t chosen = run_start + run_len / 2;
+        offsets[i] = (uint32_t)(chosen * res_ms);
+
+        for (uint64_t k = 0; k < releases; k++) {
+            load[((chosen * res_ms + k * interval) / res_ms) % slots] += weight;
+        }
+    }
+
+    free(load);
+    free(cost);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef SCHED_PHASE_H
+#define SCHED_PHASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Longest hyperperiod the phase assignment accepts, in milliseconds. */
+#define SCHED_PHASE_MAX_HYPERPERIOD_MS  3600000u
+
+/** Maximum number of slots the hyperperiod is divided into. */
+#define SCHED_PHASE_MAX_SLOTS           65536u
+
+/**
+ * @brief A periodic task as seen by the phase assignment.
+ */
+typedef struct sched_phase_task {
+    uint32_t interval_ms;
+    uint32_t wcet_us;       /**< Worst-case execution time, 0 counting as 1 */
+} sched_phase_task_t;
+
+/**
+ * @brief Assigns release offsets that spread periodic tasks over the hyperperiod.
+ * @details The hyperperiod, the least common multiple of the intervals, is
+ * divided into slots of one millisecond, or of a power of two milliseconds
+ * when it is longer than SCHED_PHASE_MAX_SLOTS. Tasks are placed greedily in
+ * the order given: each gets the offset within its interval that minimizes
+ * the peak load of the slots its releases fall into, and among equally good
+ * offsets the one in the middle of the longest run of them, which keeps
+ * tasks of the same period as far apart as possible. Harmonic periods keep
+ * the hyperperiod short; the assignment is declined when it is longer than
+ * SCHED_PHASE_MAX_HYPERPERIOD_MS.
+ *
+ * @param tasks The tasks, most important first. Intervals must be non-zero.
+ * @param count Number of tasks.
+ * @param offsets Receives the offset of each task, below its interval, in milliseconds.
+ * @return Returns 0 on success, or -1 if the hyperperiod is too long or the
+ *         working memory cannot be allocated.
+ */
+int sched_phase_assign(const sched_phase_task_t *tasks, size_t count, uint32_t *offsets);
+
+#endif
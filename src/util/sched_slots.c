@@ -0,0 +1,50 @@
+#include "sched_slots.h"
+
+#include <stdlib.h>
+
+#define SLOTS_TOP(head)         ((uint32_t)(head))
+#define SLOTS_HEAD(tag, top)    (((uint64_t)(tag) << 32) | (uint32_t)(top))
+
+int sched_slots_init(sched_slots_t *slots, size_t capacity) {
+    slots->next = malloc((capacity ? capacity : 1) * sizeof(atomic_uint));
+    if (!slots->next) {
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&slots->next[i], i + 1 < capacity ? (unsigned)(i + 2) : 0u);
+    }
+    slots->capacity = capacity;
+    atomic_init(&slots->head, SLOTS_HEAD(0, capacity ? 1 : 0));
+    return 0;
+}
+
+int sched_slots_take(sched_slots_t *slots, size_t *idx) {
+    uint64_t head = atomic_load_explicit(&slots->head, memory_order_acquire);
+    for (;;) {
+        uint32_t top = SLOTS_TOP(head);
+        if (top == 0) {
+            return -1;
+        }
+        /* The link may be stale if another thread took the slot, the tag then fails the swap. */
+        uint32_t next = atomic_load_explicit(&slots->next[top - 1], memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&slots->head, &head, SLOTS_HEAD((head >> 32) + 1, next),
+                memory_order_acquire, memory_order_acquire)) {
+            *idx = top - 1;
+            return 0;
+        }
+    }
+}
+
+void sched_slots_put(sched_slots_t *slots, size_t idx) {
+    uint64_t head = atomic_load_explicit(&slots->head, memory_order_relaxed);
+    do {
+        atomic_store_explicit(&slots->next[idx], SLOTS_TOP(head), memory_order_relaxed);
+    } while (!atomic_compare_exchange_weak_explicit(&slots->head, &head, SLOTS_HEAD((head >> 32) + 1, idx + 1),
+                memory_order_release, memory_order_relaxed));
+}
+
+void sched_slots_destroy(sched_slots_t *slots) {
+    free(slots->next);
+    slots->next = NULL;
+    slots->capacity = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef SCHED_SLOTS_H
+#define SCHED_SLOTS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Lock-free free list of task table slots.
+ * @details A Treiber stack threaded through a preallocated array of links,
+ * so taking and returning a slot never allocates. The head packs the top slot
+ * with a counter bumped on every update, which keeps a thread that was
+ * preempted between reading the head and swapping it from reinstating a stale
+ * link (the ABA problem).
+ */
+typedef struct sched_slots {
+    atomic_uint     *next;      /**< Link of each free slot, as index + 1, 0 ending the list */
+    size_t           capacity;
+    _Atomic uint64_t head;      /**< Update counter in the high half, top slot + 1 in the low half */
+} sched_slots_t;
+
+/**
+ * @brief Allocates a free list holding every slot below capacity.
+ * @details Slots are handed out in ascending order until the first is
+ * returned.
+ *
+ * @param slots Pointer to the free list to initialize.
+ * @param capacity Number of slots, below 2^32.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int sched_slots_init(sched_slots_t *slots, size_t capacity);
+
+/**
+ * @brief Takes a free slot. Safe from any thread.
+ *
+ * @param slots Pointer to the free list.
+ * @param idx Receives the slot.
+ * @return Returns 0 on success, or -1 if every slot is in use.
+ */
+int sched_slots_take(sched_slots_t *slots, size_t *idx);
+
+/**
+ * @brief Returns a slot to the free list. Safe from any thread.
+ *
+ * @param slots Pointer to the free list.
+ * @param idx The slot, which must have been taken.
+ */
+void sched_slots_put(sched_slots_t *slots, size_t idx);
+
+/**
+ * @brief Releases the storage owned by the free list.
+ *
+ * @param slots Pointer to the free list.
+ */
+void sched_slots_destroy(sched_slots_t *slots);
+
+#endif
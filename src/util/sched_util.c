@@ -1,31 +1,105 @@
+#define _GNU_SOURCE
 #include "sched_util.h"
 #include "scheduler.h"
 
+#include <sched.h>
 #include <stdlib.h>
+#include <string.h>
 
-/**
- * @brief Comparison function for sorting scheduler tasks by priority.
- * @details Compares two scheduler task objects by their priority values.
- * The function returns:
- * - A negative value if the priority of the first task is less than the second.
- * - A positive value if the priority of the first task is greater than the second.
- * - Zero if both tasks have the same priority.
- *
- * This function is designed to be used with sorting algorithms such as qsort.
- *
- * @param a Pointer to the first sched_task_t object.
- * @param b Pointer to the second sched_task_t object.
- * @return Integer representing the relative priority of the two tasks.
- */
-int sched_task_cmp(const void *a, const void *b) {
-    const sched_task_t *ta = a;
-    const sched_task_t *tb = b;
-    if (ta->priority < tb->priority) return -1;
-    if (ta->priority > tb->priority) return  1;
-    return 0;
+void sort_tasks_by_priority(void *sched) {
+    sched_t *s = sched;
+
+    /* Counting sort on the 8-bit priority, stable in slot order. */
+    size_t starts[257] = { 0 };
+    for (size_t i = 0; i < s->tasks_count; i++) {
+        if (s->tasks[i].active || s->tasks[i].paused) {
+            starts[256 - s->tasks[i].priority]++;
+        }
+    }
+    for (size_t p = 1; p < 257; p++) {
+        starts[p] += starts[p - 1];
+    }
+    for (size_t i = 0; i < s->tasks_count; i++) {
+        if (s->tasks[i].active || s->tasks[i].paused) {
+            s->order[starts[255 - s->tasks[i].priority]++] = i;
+        }
+    }
+    s->order_count  = starts[256];
+    s->order_sorted = 1;
 }
 
-void sort_tasks_by_priority(const void *sched) {
-    const sched_t *s = sched;
-    qsort(s->tasks, s->tasks_count, sizeof(sched_task_t), sched_task_cmp);
+void *sched_calloc_aligned(size_t count, size_t size) {
+    if (count == 0) {
+        count = 1;
+    }
+    if (size && count > SIZE_MAX / size - SCHED_CACHE_LINE) {
+        return NULL;
+    }
+    size_t bytes = (count * size + SCHED_CACHE_LINE - 1) / SCHED_CACHE_LINE * SCHED_CACHE_LINE;
+    void *ptr = aligned_alloc(SCHED_CACHE_LINE, bytes);
+    if (ptr) {
+        memset(ptr, 0, bytes);
+    }
+    return ptr;
+}
+
+int sched_attr_pin_cpu(pthread_attr_t *attr, int cpu) {
+    if (cpu < 0 || cpu >= 64) {
+        return -1;
+    }
+    return sched_attr_set_cpus(attr, UINT64_C(1) << cpu);
+}
+
+int sched_attr_set_cpus(pthread_attr_t *attr, uint64_t cpus) {
+#if defined(__linux__)
+    if (cpus == 0) {
+        return -1;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; cpu++) {
+        if (cpus & (UINT64_C(1) << cpu)) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return pthread_attr_setaffinity_np(attr, sizeof(set), &set) == 0 ? 0 : -1;
+#else
+    (void)attr;
+    (void)cpus;
+    return -1;
+#endif
+}
+
+int sched_parse_cpus(const char *list, uint64_t *cpus) {
+    uint64_t mask = 0;
+    const char *p = list;
+    while (*p) {
+        char *end;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p) {
+            return -1;
+        }
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtoul(p + 1, &end, 10);
+            if (end == p + 1) {
+                return -1;
+            }
+            p = end;
+        }
+        if (first > last || last >= 64) {
+            return -1;
+        }
+        for (unsigned long cpu = first; cpu <= last; cpu++) {
+            mask |= UINT64_C(1) << cpu;
+        }
+        if (*p == ',') {
+            p++;
+        } else if (*p) {
+            return -1;
+        }
+    }
+    *cpus = mask;
+    return 0;
 }
@@ -1,11 +1,60 @@
 #ifndef SCHED_UTIL_H
 #define SCHED_UTIL_H
 
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Cache line size assumed for the layout of shared tables. */
+#define SCHED_CACHE_LINE 64
+
 /**
  * @brief Sorts the tasks in the scheduler by priority.
- * @details This function organizes the tasks in the scheduler structure in
- * descending order of priority, ensuring that higher-priority tasks are scheduled first.
+ * @details This function fills the priority order of the scheduler with the
+ * slots of its live tasks in descending order of priority, ensuring that
+ * higher-priority tasks are scheduled first. Tasks of equal priority keep
+ * their slot order. The task table itself is not moved, so slots and task
+ * handles stay valid.
+ */
+void sort_tasks_by_priority(void *sched);
+
+/**
+ * @brief Allocates a zeroed array starting on a cache line.
+ * @details The size is rounded up to whole cache lines, so that elements
+ * declared with a cache line alignment never share a line with another
+ * allocation. The array is released with free().
+ *
+ * @param count Number of elements.
+ * @param size Size of one element.
+ * @return Pointer to the array, or NULL if the allocation fails.
+ */
+void *sched_calloc_aligned(size_t count, size_t size);
+
+/**
+ * @brief Restricts threads created with the given attributes to a single CPU.
+ *
+ * @param attr The thread attributes to modify.
+ * @param cpu Index of the CPU the thread may run on.
+ * @return Returns 0 on success, or -1 on failure or if affinity is not supported.
+ */
+int sched_attr_pin_cpu(pthread_attr_t *attr, int cpu);
+
+/**
+ * @brief Restricts threads created with the given attributes to a set of CPUs.
+ *
+ * @param attr The thread attributes to modify.
+ * @param cpus Bitmask of the allowed CPUs, bit n standing for CPU n.
+ * @return Returns 0 on success, or -1 on failure or if affinity is not supported.
+ */
+int sched_attr_set_cpus(pthread_attr_t *attr, uint64_t cpus);
+
+/**
+ * @brief Parses a CPU list such as "0,2-3" into a bitmask.
+ *
+ * @param list Comma separated CPU indices and ranges, each below 64.
+ * @param cpus Receives the bitmask.
+ * @return Returns 0 on success, or -1 if the list is malformed.
  */
-void sort_tasks_by_priority(const void *sched);
+int sched_parse_cpus(const char *list, uint64_t *cpus);
 
 #endif
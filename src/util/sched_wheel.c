@@ -0,0 +1,210 @@
+#include "sched_wheel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SLOT_MASK (SCHED_WHEEL_SLOTS - 1u)
+
+static inline void mark_slot(sched_wheel_t *wheel, int level, uint32_t slot) {
+    wheel->occupied[level][slot >> 6] |= UINT64_C(1) << (slot & 63);
+}
+
+static inline void clear_slot(sched_wheel_t *wheel, int level, uint32_t slot) {
+    wheel->occupied[level][slot >> 6] &= ~(UINT64_C(1) << (slot & 63));
+}
+
+/**
+ * @brief Finds the first occupied level-0 slot at or after from.
+ * @details The search stops at the end of the level, because crossing it
+ * requires a cascade from the upper levels first.
+ *
+ * @return The slot number, or -1 if no slot in [from, SLOTS) is occupied.
+ */
+static int find_slot(const sched_wheel_t *wheel, uint32_t from) {
+    for (uint32_t word = from >> 6; word < SCHED_WHEEL_SLOTS / 64; word++) {
+        uint64_t bits = wheel->occupied[0][word];
+        if (word == from >> 6) {
+            bits &= ~UINT64_C(0) << (from & 63);
+        }
+        if (bits) {
+            return (int)(word * 64 + (uint32_t)__builtin_ctzll(bits));
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Links an entry into the bucket matching its distance from current.
+ */
+static void link_entry(sched_wheel_t *wheel, uint32_t idx) {
+    uint32_t due = wheel->due_ms[idx];
+    if ((int32_t)(due - wheel->current) < 0) {
+        due = wheel->current;
+    }
+    uint32_t delta = due - wheel->current;
+
+    int level = 0;
+    while (level < SCHED_WHEEL_LEVELS - 1 && delta >= (1u << (SCHED_WHEEL_SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    uint32_t slot = (due >> (SCHED_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+
+    uint32_t *head = &wheel->head[level][slot];
+    wheel->next[idx]   = *head;
+    wheel->prev[idx]   = SCHED_WHEEL_NIL;
+    if (*head != SCHED_WHEEL_NIL) {
+        wheel->prev[*head] = idx;
+    }
+    *head = idx;
+    wheel->bucket[idx] = (int32_t)(level * SCHED_WHEEL_SLOTS + slot);
+    mark_slot(wheel, level, slot);
+}
+
+static void unlink_entry(sched_wheel_t *wheel, uint32_t idx) {
+    int level     = wheel->bucket[idx] / (int32_t)SCHED_WHEEL_SLOTS;
+    uint32_t slot = (uint32_t)wheel->bucket[idx] % SCHED_WHEEL_SLOTS;
+
+    if (wheel->prev[idx] != SCHED_WHEEL_NIL) {
+        wheel->next[wheel->prev[idx]] = wheel->next[idx];
+    } else {
+        wheel->head[level][slot] = wheel->next[idx];
+    }
+    if (wheel->next[idx] != SCHED_WHEEL_NIL) {
+        wheel->prev[wheel->next[idx]] = wheel->prev[idx];
+    }
+    if (wheel->head[level][slot] == SCHED_WHEEL_NIL) {
+        clear_slot(wheel, level, slot);
+    }
+    wheel->bucket[idx] = -1;
+}
+
+/**
+ * @brief Moves every entry of an upper-level slot down to the lower levels.
+ */
+static void cascade(sched_wheel_t *wheel, int level, uint32_t slot) {
+    uint32_t idx = wheel->head[level][slot];
+    wheel->head[level][slot] = SCHED_WHEEL_NIL;
+    clear_slot(wheel, level, slot);
+    while (idx != SCHED_WHEEL_NIL) {
+        uint32_t next = wheel->next[idx];
+        link_entry(wheel, idx);
+        idx = next;
+    }
+}
+
+/**
+ * @brief Advances current by one tick, cascading on level boundaries.
+ */
+static void advance(sched_wheel_t *wheel, uint32_t tick) {
+    wheel->current = tick;
+    if ((tick & SLOT_MASK) != 0) {
+        return;
+    }
+    /* Cascade the highest affected level first so entries flow downwards. */
+    int top = 1;
+    while (top < SCHED_WHEEL_LEVELS - 1
+           && ((tick >> (SCHED_WHEEL_SLOT_BITS * top)) & SLOT_MASK) == 0) {
+        top++;
+    }
+    for (int level = top; level >= 1; level--) {
+        cascade(wheel, level, (tick >> (SCHED_WHEEL_SLOT_BITS * level)) & SLOT_MASK);
+    }
+}
+
+int sched_wheel_init(sched_wheel_t *wheel, size_t capacity, uint32_t now_ms) {
+    size_t n = capacity ? capacity : 1;
+    wheel->due_ms = calloc(n, sizeof(uint32_t));
+    wheel->next   = calloc(n, sizeof(uint32_t));
+    wheel->prev   = calloc(n, sizeof(uint32_t));
+    wheel->bucket = calloc(n, sizeof(int32_t));
+    if (!wheel->due_ms || !wheel->next || !wheel->prev || !wheel->bucket) {
+        sched_wheel_destroy(wheel);
+        return -1;
+    }
+    wheel->capacity = capacity;
+    sched_wheel_clear(wheel, now_ms);
+    return 0;
+}
+
+void sched_wheel_clear(sched_wheel_t *wheel, uint32_t now_ms) {
+    memset(wheel->head, 0xFF, sizeof(wheel->head));
+    memset(wheel->occupied, 0, sizeof(wheel->occupied));
+    for (size_t i = 0; i < wheel->capacity; i++) {
+        wheel->bucket[i] = -1;
+    }
+    wheel->current = now_ms;
+    wheel->count   = 0;
+}
+
+int sched_wheel_insert(sched_wheel_t *wheel, size_t idx, uint32_t due_ms) {
+    if (idx >= wheel->capacity || wheel->bucket[idx] >= 0) {
+        return -1;
+    }
+    wheel->due_ms[idx] = due_ms;
+    link_entry(wheel, (uint32_t)idx);
+    wheel->count++;
+    return 0;
+}
+
+int sched_wheel_remove(sched_wheel_t *wheel, size_t idx) {
+    if (idx >= wheel->capacity || wheel->bucket[idx] < 0) {
+        return -1;
+    }
+    unlink_entry(wheel, (uint32_t)idx);
+    wheel->count--;
+    return 0;
+}
+
+int sched_wheel_pop_due(sched_wheel_t *wheel, uint32_t now_ms, size_t *idx) {
+    for (;;) {
+        if ((int32_t)(now_ms - wheel->current) < 0) {
+            return -1;
+        }
+        uint32_t slot = wheel->current & SLOT_MASK;
+        uint32_t head = wheel->head[0][slot];
+        if (head != SCHED_WHEEL_NIL) {
+            unlink_entry(wheel, head);
+            wheel->count--;
+            *idx = head;
+            return 0;
+        }
+        if (wheel->current == now_ms) {
+            return -1;
+        }
+        /* Skip empty level-0 slots, stopping at now_ms or the next boundary. */
+        int found = find_slot(wheel, slot);
+        uint32_t target = (found >= 0)
+            ? (wheel->current & ~SLOT_MASK) + (uint32_t)found
+            : (wheel->current | SLOT_MASK) + 1;
+        if ((int32_t)(target - now_ms) > 0) {
+            target = now_ms;
+        }
+        advance(wheel, target);
+    }
+}
+
+int sched_wheel_next_due(const sched_wheel_t *wheel, uint32_t *due_ms) {
+    if (wheel->count == 0) {
+        return -1;
+    }
+    int found = find_slot(wheel, wheel->current & SLOT_MASK);
+    if (found >= 0) {
+        *due_ms = (wheel->current & ~SLOT_MASK) + (uint32_t)found;
+    } else {
+        *due_ms = (wheel->current | SLOT_MASK) + 1;
+    }
+    return 0;
+}
+
+void sched_wheel_destroy(sched_wheel_t *wheel) {
+    free(wheel->due_ms);
+    free(wheel->next);
+    free(wheel->prev);
+    free(wheel->bucket);
+    wheel->due_ms   = NULL;
+    wheel->next     = NULL;
+    wheel->prev     = NULL;
+    wheel->bucket   = NULL;
+    wheel->capacity = 0;
+    wheel->count    = 0;
+}
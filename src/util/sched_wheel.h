@@ -0,0 +1,104 @@
+#ifndef SCHED_WHEEL_H
+#define SCHED_WHEEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCHED_WHEEL_LEVELS     4
+#define SCHED_WHEEL_SLOT_BITS  8
+#define SCHED_WHEEL_SLOTS      (1u << SCHED_WHEEL_SLOT_BITS)
+#define SCHED_WHEEL_NIL        UINT32_MAX
+
+/**
+ * @brief Hierarchical timing wheel with a resolution of one millisecond.
+ * @details Four levels of 256 slots cover the full 32-bit millisecond range.
+ * Entries live in level 0 once they are less than 256 ms away and are
+ * cascaded down from the upper levels as the wheel turns. Insertion and
+ * removal are O(1); expiry is O(1) per entry plus one cascade per 256 ms.
+ * Entries are identified by the index of their task in the scheduler task
+ * table, and links are stored in side arrays so the wheel never allocates
+ * after initialization.
+ */
+typedef struct sched_wheel {
+    uint32_t  current;      /**< Next tick that has not been expired yet */
+    size_t    count;        /**< Number of linked entries */
+    size_t    capacity;
+    uint32_t *due_ms;       /**< Per-entry expiry time */
+    uint32_t *next;         /**< Per-entry list links */
+    uint32_t *prev;
+    int32_t  *bucket;       /**< Per-entry bucket (level * SLOTS + slot), -1 if unlinked */
+    uint32_t  head[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SLOTS];
+    uint64_t  occupied[SCHED_WHEEL_LEVELS][SCHED_WHEEL_SLOTS / 64];
+} sched_wheel_t;
+
+/**
+ * @brief Allocates the wheel link storage for up to capacity entries.
+ *
+ * @param wheel Pointer to the wheel to initialize.
+ * @param capacity Maximum number of entries, usually the task table size.
+ * @param now_ms Current time; the wheel starts turning from this tick.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int sched_wheel_init(sched_wheel_t *wheel, size_t capacity, uint32_t now_ms);
+
+/**
+ * @brief Removes all entries and restarts the wheel at now_ms.
+ *
+ * @param wheel Pointer to the wheel.
+ * @param now_ms Tick the wheel restarts from.
+ */
+void sched_wheel_clear(sched_wheel_t *wheel, uint32_t now_ms);
+
+/**
+ * @brief Links an entry into the wheel in O(1).
+ * @details An entry whose due time has already passed expires on the next
+ * call to sched_wheel_pop_due().
+ *
+ * @param wheel Pointer to the wheel.
+ * @param idx Entry index, must be lower than the wheel capacity.
+ * @param due_ms Time at which the entry expires.
+ * @return Returns 0 on success, or -1 if idx is out of range or already linked.
+ */
+int sched_wheel_insert(sched_wheel_t *wheel, size_t idx, uint32_t due_ms);
+
+/**
+ * @brief Unlinks an entry from the wheel in O(1).
+ *
+ * @param wheel Pointer to the wheel.
+ * @param idx Entry index.
+ * @return Returns 0 on success, or -1 if the entry is not linked.
+ */
+int sched_wheel_remove(sched_wheel_t *wheel, size_t idx);
+
+/**
+ * @brief Turns the wheel up to now_ms and removes one expired entry.
+ * @details Entries that expire on the same tick are returned in an
+ * unspecified order; the wheel orders them neither by insertion nor by
+ * priority.
+ *
+ * @param wheel Pointer to the wheel.
+ * @param now_ms Current time.
+ * @param idx Receives the index of the expired entry.
+ * @return Returns 0 if an entry was expired, or -1 if nothing is due.
+ */
+int sched_wheel_pop_due(sched_wheel_t *wheel, uint32_t now_ms, size_t *idx);
+
+/**
+ * @brief Returns the earliest tick at which the wheel needs attention.
+ * @details The value is exact for entries in level 0. When only upper levels
+ * are occupied, the next cascade boundary is returned instead.
+ *
+ * @param wheel Pointer to the wheel.
+ * @param due_ms Receives the tick.
+ * @return Returns 0 on success, or -1 if the wheel is empty.
+ */
+int sched_wheel_next_due(const sched_wheel_t *wheel, uint32_t *due_ms);
+
+/**
+ * @brief Releases the storage owned by the wheel.
+ *
+ * @param wheel Pointer to the wheel.
+ */
+void sched_wheel_destroy(sched_wheel_t *wheel);
+
+#endif
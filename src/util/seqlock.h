@@ -0,0 +1,67 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+
+/**
+ * @brief Sequence lock for small, frequently written and rarely read records.
+ * @details The counter is odd while a writer updates the record. Writers
+ * serialize on the counter itself with a compare-and-swap, so there is no
+ * shared mutex; readers never block writers and retry if a write overlapped
+ * their copy.
+ */
+typedef atomic_uint seqlock_t;
+
+/**
+ * @brief Starts a write section, spinning while another writer holds it.
+ *
+ * @param lock Pointer to the sequence lock.
+ */
+static inline void seqlock_write_begin(seqlock_t *lock) {
+    unsigned seq = atomic_load_explicit(lock, memory_order_relaxed);
+    for (;;) {
+        if (!(seq & 1u) && atomic_compare_exchange_weak_explicit(lock, &seq, seq + 1,
+                memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+        seq = atomic_load_explicit(lock, memory_order_relaxed);
+    }
+    /* Keep the record stores after the odd counter becomes visible. */
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Ends a write section and publishes the record.
+ *
+ * @param lock Pointer to the sequence lock.
+ */
+static inline void seqlock_write_end(seqlock_t *lock) {
+    atomic_fetch_add_explicit(lock, 1, memory_order_release);
+}
+
+/**
+ * @brief Starts a read section.
+ *
+ * @param lock Pointer to the sequence lock.
+ * @return The sequence to pass to seqlock_read_retry().
+ */
+static inline unsigned seqlock_read_begin(seqlock_t *lock) {
+    unsigned seq;
+    while ((seq = atomic_load_explicit(lock, memory_order_acquire)) & 1u) {
+    }
+    return seq;
+}
+
+/**
+ * @brief Checks whether a read section overlapped a write.
+ *
+ * @param lock Pointer to the sequence lock.
+ * @param seq Sequence returned by seqlock_read_begin().
+ * @return Non-zero if the copy is torn and must be read again.
+ */
+static inline int seqlock_read_retry(seqlock_t *lock, unsigned seq) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(lock, memory_order_relaxed) != seq;
+}
+
+#endif
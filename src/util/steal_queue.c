@@ -0,0 +1,52 @@
+#include <stdlib.h>
+
+#include "steal_queue.h"
+
+int steal_queue_init(steal_queue_t *queue, size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    queue->buffer = calloc(size, sizeof(*queue->buffer));
+    if (!queue->buffer) {
+        return -1;
+    }
+    queue->mask = size - 1;
+    atomic_init(&queue->top, 0);
+    atomic_init(&queue->bottom, 0);
+    return 0;
+}
+
+int steal_queue_push(steal_queue_t *queue, void *item) {
+    int64_t b = atomic_load_explicit(&queue->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&queue->top, memory_order_acquire);
+    if ((size_t)(b - t) > queue->mask) {
+        return -1;
+    }
+    atomic_store_explicit(&queue->buffer[(size_t)b & queue->mask], item, memory_order_relaxed);
+    /* Publish the entry before the new bottom becomes visible to consumers. */
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&queue->bottom, b + 1, memory_order_relaxed);
+    return 0;
+}
+
+void *steal_queue_steal(steal_queue_t *queue) {
+    int64_t t = atomic_load_explicit(&queue->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&queue->bottom, memory_order_acquire);
+    if (t >= b) {
+        return NULL;
+    }
+    void *item = atomic_load_explicit(&queue->buffer[(size_t)t & queue->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&queue->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return item;
+}
+
+void steal_queue_destroy(steal_queue_t *queue) {
+    free(queue->buffer);
+    queue->buffer = NULL;
+    queue->mask = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef STEAL_QUEUE_H
+#define STEAL_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Bounded single-producer, multi-consumer queue of pointers.
+ * @details One producer thread pushes at the tail, while any number of
+ * consumers take from the head with a compare-and-swap, in FIFO order. This
+ * is the stealing half of a Chase-Lev deque without the owner pop. The
+ * buffer has a fixed power-of-two capacity and is never grown, so a push
+ * fails instead of reallocating while consumers may still be reading it. The
+ * two ends live on separate cache lines, as the producer and the consumers
+ * write them concurrently.
+ */
+typedef struct steal_queue {
+    _Alignas(64) _Atomic int64_t top;
+    _Alignas(64) _Atomic int64_t bottom;
+    _Atomic(void *) *buffer;
+    size_t           mask;
+} steal_queue_t;
+
+/**
+ * @brief Allocates a queue able to hold at least capacity entries.
+ *
+ * @param queue Pointer to the queue to initialize.
+ * @param capacity Minimum number of entries, rounded up to a power of two.
+ * @return Returns 0 on success, or -1 if the allocation fails.
+ */
+int steal_queue_init(steal_queue_t *queue, size_t capacity);
+
+/**
+ * @brief Pushes an entry at the tail. Producer only.
+ *
+ * @param queue Pointer to the queue.
+ * @param item Entry to push, must not be NULL.
+ * @return Returns 0 on success, or -1 if the queue is full.
+ */
+int steal_queue_push(steal_queue_t *queue, void *item);
+
+/**
+ * @brief Takes the oldest entry from the head. Safe from any thread.
+ *
+ * @param queue Pointer to the queue.
+ * @return The entry, or NULL if the queue is empty or another consumer won the race.
+ */
+void *steal_queue_steal(steal_queue_t *queue);
+
+/**
+ * @brief Releases the storage owned by the queue.
+ *
+ * @param queue Pointer to the queue.
+ */
+void steal_queue_destroy(steal_queue_t *queue);
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Regression test: a one-shot task that runs on time is not an overrun.
+ *
+ * A one-shot has no next release, so it must not be given a deadline equal
+ * to its own release and count as late whatever it does. Both one-shot entry
+ * points of the scheduler and the threaded scheduler are covered.
+ */
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "logger.h"
+#include "scheduler.h"
+#include "scheduler_pt.h"
+#include "system.h"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+/* Generous bound for the one-shot to run, it is due after 2 ms. */
+#define TIMEOUT_US 1000000
+/* Work done by the one-shot, so it always ends after its release. */
+#define WORK_US    100
+
+static atomic_int runs;
+
+static void oneshot_task(void *data) {
+    (void)data;
+    uint64_t end_us = micros64() + WORK_US;
+    while (micros64() < end_us) {
+    }
+    atomic_fetch_add(&runs, 1);
+}
+
+/**
+ * Ticks the loop with the real clock until the one-shot has run.
+ */
+static void run_loop(sched_t *sched) {
+    uint64_t end_us = micros64() + TIMEOUT_US;
+    while (atomic_load(&runs) == 0 && micros64() < end_us) {
+        sched_tick(sched, micros64());
+    }
+}
+
+static void *pt_thread(void *arg) {
+    sched_pt_start((sched_t *)arg);
+    return NULL;
+}
+
+/**
+ * Waits until the threaded scheduler has accounted the run of a task. The
+ * counters cannot be read before the dispatcher has added the task.
+ */
+static void wait_accounted(sched_t *sched, size_t idx, sched_task_counters_t *counters) {
+    uint64_t end_us = micros64() + TIMEOUT_US;
+    do {
+        if (sched_get_task_counters(sched, idx, counters) != 0) {
+            counters->run_count = 0;
+        }
+    } while (counters->run_count == 0 && micros64() < end_us);
+}
+
+int main(void) {
+    system_init();
+    logger_enable(0);
+
+    sched_t sched;
+    sched_task_counters_t counters;
+
+    /* Added directly to the task table. */
+    CHECK(sched_init(&sched, 4) == 0);
+    sched_handle_t handle = sched_add_oneshot(&sched, oneshot_task, NULL, 2, 0, "added");
+    CHECK(handle != SCHED_HANDLE_INVALID);
+    run_loop(&sched);
+    CHECK(sched_get_task_counters(&sched, sched_handle_index(handle), &counters) == 0);
+    CHECK(counters.run_count == 1);
+    CHECK(counters.overrun_count == 0);
+    sched_destroy(&sched);
+
+    /* Submitted through the submission queue. */
+    atomic_store(&runs, 0);
+    CHECK(sched_init(&sched, 4) == 0);
+    handle = sched_submit_oneshot(&sched, oneshot_task, NULL, 2, 0, "submitted");
+    CHECK(handle != SCHED_HANDLE_INVALID);
+    run_loop(&sched);
+    CHECK(sched_get_task_counters(&sched, sched_handle_index(handle), &counters) == 0);
+    CHECK(counters.run_count == 1);
+    CHECK(counters.overrun_count == 0);
+    sched_destroy(&sched);
+
+    /* Submitted to the threaded scheduler. */
+    atomic_store(&runs, 0);
+    CHECK(sched_pt_init(&sched, 4, 1) == 0);
+    handle = sched_submit_oneshot(&sched, oneshot_task, NULL, 2, 0, "threaded");
+    CHECK(handle != SCHED_HANDLE_INVALID);
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, pt_thread, &sched) == 0);
+    wait_accounted(&sched, sched_handle_index(handle), &counters);
+    sched_stop(&sched);
+    pthread_join(thread, NULL);
+    CHECK(counters.run_count == 1);
+    CHECK(counters.overrun_count == 0);
+    sched_pt_destroy(&sched);
+
+    printf("test_sched_oneshot: ok\n");
+    return 0;
+}
@@ -0,0 +1,82 @@
+/**
+ * Regression test: a task that cancels itself from its callback and arms a
+ * new task in the same callback.
+ *
+ * The new task must not inherit the slot of the cancelled one while its run
+ * is still being accounted, or the end of that run retires the new one-shot
+ * before it runs and moves the release of a new periodic task.
+ */
+#include <stdio.h>
+
+#include "logger.h"
+#include "scheduler.h"
+#include "system.h"
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1; \
+        } \
+    } while (0)
+
+static sched_t sched;
+static sched_handle_t self;
+static int rearm_periodic;
+static int first_runs;
+static int second_runs;
+
+static void second_task(void *data) {
+    (void)data;
+    second_runs++;
+}
+
+static void first_task(void *data) {
+    (void)data;
+    first_runs++;
+    sched_cancel_task(&sched, self);
+    if (rearm_periodic) {
+        sched_add_task(&sched, second_task, NULL, 10, 0, "second");
+    } else {
+        sched_add_oneshot(&sched, second_task, NULL, 0, 0, "second");
+    }
+}
+
+/**
+ * Runs the first task, then ticks until the second one has run or 100 ms pass.
+ */
+static void run(uint64_t base_us) {
+    for (uint64_t t = 0; t <= 100; t++) {
+        sched_tick(&sched, base_us + t * 1000);
+    }
+}
+
+int main(void) {
+    system_init();
+    logger_enable(0);
+
+    /* A one-shot arming a one-shot. */
+    CHECK(sched_init(&sched, 4) == 0);
+    self = sched_add_oneshot(&sched, first_task, NULL, 5, 0, "first");
+    CHECK(self != SCHED_HANDLE_INVALID);
+    run(micros64());
+    CHECK(first_runs == 1);
+    CHECK(second_runs == 1);
+    sched_destroy(&sched);
+
+    /* A periodic task replacing itself with another periodic task. */
+    first_runs = 0;
+    second_runs = 0;
+    rearm_periodic = 1;
+    CHECK(sched_init(&sched, 4) == 0);
+    CHECK(sched_add_task(&sched, first_task, NULL, 5, 0, "first") == 0);
+    self = sched_task_handle(&sched, 0);
+    uint64_t base_us = micros64();
+    run(base_us);
+    CHECK(first_runs == 1);
+    /* Released every 10 ms from the run of the first task, about 5 ms in. */
+    CHECK(second_runs >= 9 && second_runs <= 10);
+    sched_destroy(&sched);
+
+    printf("test_sched_rearm: ok\n");
+    return 0;
+}
@@ -0,0 +1,181 @@
+/**
+ * Binary log decoder.
+ *
+ * Turns a binary log written through LOG_BIN() and logger_start_binary()
+ * back into the text format of the logger, one line per message. With -m,
+ * timestamps are printed on the micros64() timeline, as with
+ * LOGGER_TIME_MONOTONIC.
+ *
+ * Usage: rjos_logdecode [-m] <binary log> [text log]
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger.h"
+#include "util/log_format.h"
+
+/**
+ * A call site defined in the binary log.
+ */
+typedef struct site {
+    char *format;
+    int   level;
+} site_t;
+
+static site_t *sites;
+static size_t  site_capacity;
+static int     monotonic;
+
+static int read_exact(FILE *in, void *buf, size_t len) {
+    return fread(buf, 1, len, in) == len ? 0 : -1;
+}
+
+static void clear_sites(void) {
+    for (size_t i = 0; i < site_capacity; i++) {
+        free(sites[i].format);
+        sites[i].format = NULL;
+    }
+}
+
+static int define_site(uint32_t id, int level, char *format) {
+    if (id >= site_capacity) {
+        size_t capacity = site_capacity ? site_capacity : 64;
+        while (capacity <= id) {
+            capacity *= 2;
+        }
+        site_t *grown = realloc(sites, capacity * sizeof(site_t));
+        if (!grown) {
+            return -1;
+        }
+        memset(grown + site_capacity, 0, (capacity - site_capacity) * sizeof(site_t));
+        sites = grown;
+        site_capacity = capacity;
+    }
+    free(sites[id].format);
+    sites[id].format = format;
+    sites[id].level  = level;
+    return 0;
+}
+
+static void print_event(FILE *out, uint64_t anchor_us, uint64_t ts_us, const site_t *site,
+    const uint8_t *payload, size_t len) {
+    uint64_t now_us = monotonic ? ts_us : anchor_us + ts_us;
+    char time_str[32];
+    if (monotonic) {
+        snprintf(time_str, sizeof(time_str), "%llu", (unsigned long long)(now_us / 1000000));
+    } else {
+        time_t seconds = (time_t)(now_us / 1000000);
+        struct tm local_time;
+        if (localtime_r(&seconds, &local_time)) {
+            strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", &local_time);
+        } else {
+            strncpy(time_str, "UNKNOWN TIME", sizeof(time_str));
+        }
+    }
+    char message[4096];
+    if (log_format_render(message, sizeof(message), site->format, payload, len) != 0) {
+        fprintf(stderr, "rjos_logdecode: truncated arguments for \"%s\"\n", site->format);
+    }
+    fprintf(out, "[%s.%06u] %s: %s\n", time_str, (unsigned)(now_us % 1000000),
+        logger_level_name(site->level), message);
+}
+
+static int decode(FILE *in, FILE *out) {
+    uint64_t anchor_us = 0;
+    int have_header = 0;
+    int type;
+    while ((type = fgetc(in)) != EOF) {
+        uint32_t id;
+        uint16_t len;
+        switch (type) {
+            case 'H': {
+                char magic[7];
+                uint32_t order;
+                if (read_exact(in, magic, sizeof(magic)) != 0 || memcmp(magic, "RJOSBIN", 7) != 0 ||
+                    read_exact(in, &order, sizeof(order)) != 0 || order != 0x01020304 ||
+                    read_exact(in, &anchor_us, sizeof(anchor_us)) != 0) {
+                    fprintf(stderr, "rjos_logdecode: bad header, or written on a host of other byte order\n");
+                    return -1;
+                }
+                /* Each run numbers its call sites anew. */
+                clear_sites();
+                have_header = 1;
+                break;
+            }
+            case 'S': {
+                uint8_t level;
+                if (read_exact(in, &id, sizeof(id)) != 0 || read_exact(in, &level, sizeof(level)) != 0 ||
+                    read_exact(in, &len, sizeof(len)) != 0) {
+                    return -1;
+                }
+                char *format = malloc((size_t)len + 1);
+                if (!format || read_exact(in, format, len) != 0) {
+                    free(format);
+                    return -1;
+                }
+                format[len] = '\0';
+                if (define_site(id, level, format) != 0) {
+                    free(format);
+                    return -1;
+                }
+                break;
+            }
+            case 'E': {
+                uint64_t ts_us;
+                uint8_t payload[UINT16_MAX];
+                if (read_exact(in, &id, sizeof(id)) != 0 || read_exact(in, &ts_us, sizeof(ts_us)) != 0 ||
+                    read_exact(in, &len, sizeof(len)) != 0 || read_exact(in, payload, len) != 0) {
+                    return -1;
+                }
+                if (!have_header || id >= site_capacity || !sites[id].format) {
+                    fprintf(stderr, "rjos_logdecode: message of undefined site %u\n", id);
+                    break;
+                }
+                print_event(out, anchor_us, ts_us, &sites[id], payload, len);
+                break;
+            }
+            default:
+                fprintf(stderr, "rjos_logdecode: unknown record type 0x%02x at offset %ld\n", type, ftell(in) - 1);
+                return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *program = argv[0];
+    if (argc > 1 && strcmp(argv[1], "-m") == 0) {
+        monotonic = 1;
+        argc--;
+        argv++;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s [-m] <binary log> [text log]\n", program);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out) {
+        perror(argv[2]);
+        fclose(in);
+        return 1;
+    }
+    int rc = decode(in, out);
+    if (rc != 0 && !feof(in)) {
+        fprintf(stderr, "rjos_logdecode: corrupt binary log\n");
+    }
+    clear_sites();
+    free(sites);
+    fclose(in);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return rc == 0 ? 0 : 1;
+}